@@ -0,0 +1,173 @@
+/**
+ * @file
+ * @brief Schedule and expiry throughput, plus wakeup jitter, for managers::Scheduler
+ * @details usage: services_bench [milliseconds per steady_clock pass, default 1000]
+ */
+#include <moducom/services/scheduler.hpp>
+#include "fake_clock.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace moducom::services;
+using moducom::internal::fake_clock;
+
+typedef std::chrono::steady_clock bench_clock;
+
+template <class TDuration>
+struct Ticker : agents::PeriodicBase<TDuration>
+{
+    const TDuration interval;
+
+    explicit Ticker(TDuration interval) : interval(interval) {}
+
+    TDuration run(TDuration) override
+    {
+        return interval;
+    }
+};
+
+struct Result
+{
+    const char* clock;
+    std::size_t agents;
+    double add_ns;          ///< per add()
+    std::size_t runs;
+    double run_ns;          ///< per agent serviced, including expiry
+    std::uint64_t p50;      ///< lateness, in ticks, to within a factor of two
+    std::uint64_t p99;
+    std::uint64_t max;      ///< exact
+    const char* unit;
+};
+
+static double ns_since(bench_clock::time_point start, std::size_t n)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start);
+    return n == 0 ? 0 : double(elapsed.count()) / n;
+}
+
+template <class TScheduler>
+static void lateness(const TScheduler& scheduler, Result& r)
+{
+    typename TScheduler::histogram_type merged;
+
+    scheduler.each([&](const typename TScheduler::agent_type*,
+                       const typename TScheduler::AgentStatistics& stats)
+    {
+        merged += stats.lateness;
+    });
+
+    r.p50 = merged.quantile(0.5);
+    r.p99 = merged.quantile(0.99);
+}
+
+/// Advances fake time one tick at a time, so every run is exactly on time and what's
+/// measured is purely the scheduler's own overhead
+static Result fake(std::size_t count)
+{
+    typedef fake_clock::duration duration_type;
+    typedef managers::Scheduler<fake_clock::time_point, duration_type> scheduler_type;
+    typedef Ticker<duration_type> agent_type;
+
+    constexpr int ticks = 1000;
+
+    Result r {"fake_clock", count, 0, 0, 0, 0, 0, 0, "ticks"};
+    scheduler_type scheduler;
+    std::vector<std::unique_ptr<agent_type> > agents;
+
+    agents.reserve(count);
+    for(std::size_t i = 0; i < count; ++i)
+        agents.emplace_back(new agent_type(duration_type(1 + int(i % 64))));
+
+    auto start = bench_clock::now();
+    for(auto& agent : agents)
+        scheduler.add(agent.get(), agent->interval);
+    r.add_ns = ns_since(start, count);
+
+    start = bench_clock::now();
+    for(int t = 1; t <= ticks; ++t)
+        scheduler.run(t);
+    auto stats = scheduler.statistics();
+    r.runs = stats.runs;
+    r.run_ns = ns_since(start, r.runs);
+    r.max = stats.lateness_max.value;
+
+    lateness(scheduler, r);
+    return r;
+}
+
+/// Sleeps until each wakeup as a driver thread would, so lateness includes the OS
+/// waking us as well as the scheduler itself
+static Result steady(std::size_t count, std::chrono::milliseconds length)
+{
+    typedef bench_clock::duration duration_type;
+    typedef managers::Scheduler<bench_clock::time_point, duration_type> scheduler_type;
+    typedef Ticker<duration_type> agent_type;
+
+    using namespace std::chrono_literals;
+
+    Result r {"steady_clock", count, 0, 0, 0, 0, 0, 0, "us"};
+    // microsecond ticks, so that lateness histograms resolve jitter finely
+    scheduler_type scheduler(std::chrono::microseconds(1), bench_clock::time_point{});
+    std::vector<std::unique_ptr<agent_type> > agents;
+
+    agents.reserve(count);
+    for(std::size_t i = 0; i < count; ++i)
+        agents.emplace_back(new agent_type(10ms + std::chrono::milliseconds(i % 90)));
+
+    auto now = bench_clock::now();
+    auto start = now;
+    for(auto& agent : agents)
+        scheduler.add(agent.get(), now + agent->interval, now);
+    r.add_ns = ns_since(start, count);
+
+    start = bench_clock::now();
+    auto end = start + length;
+    std::chrono::nanoseconds busy(0);
+
+    for(now = start; now < end; now = bench_clock::now())
+    {
+        scheduler.run(now);
+        busy += bench_clock::now() - now;
+
+        bench_clock::time_point next;
+        if(scheduler.next_wakeup(next))
+            std::this_thread::sleep_until(next < end ? next : end);
+    }
+
+    auto stats = scheduler.statistics();
+    r.runs = stats.runs;
+    r.run_ns = r.runs == 0 ? 0 : double(busy.count()) / r.runs;
+    r.max = std::chrono::duration_cast<std::chrono::microseconds>(stats.lateness_max).count();
+
+    lateness(scheduler, r);
+    return r;
+}
+
+static void print(const Result& r)
+{
+    std::printf("%-12s %8zu %10.1f %10zu %10.1f %8llu %8llu %8llu %s\n",
+                r.clock, r.agents, r.add_ns, r.runs, r.run_ns,
+                (unsigned long long) r.p50,
+                (unsigned long long) r.p99,
+                (unsigned long long) r.max,
+                r.unit);
+}
+
+int main(int argc, char* argv[])
+{
+    std::chrono::milliseconds length(argc > 1 ? std::atoi(argv[1]) : 1000);
+    const std::size_t counts[] { 10, 1000, 100000 };
+
+    std::printf("%-12s %8s %10s %10s %10s %8s %8s %8s\n",
+                "clock", "agents", "add ns", "runs", "run ns", "late p50", "p99", "max");
+
+    for(std::size_t count : counts) print(fake(count));
+    for(std::size_t count : counts) print(steady(count, length));
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * @brief Manually advanced time, for exercising schedulers deterministically
+ * @details Shared by the tests and the benchmark, and by nothing which ships
+ */
+#pragma once
+
+// basic_int_duration::min() collides with the min macro some platforms define
+#undef min
+
+namespace moducom { namespace internal {
+
+// for scenarios where std::chrono::duration is a little more than we want
+template <class TInt>
+struct basic_int_duration
+{
+    TInt value;
+
+    static constexpr basic_int_duration zero()
+    {
+        return basic_int_duration {0};
+    }
+
+    static constexpr basic_int_duration min()
+    {
+        return basic_int_duration {-1};
+    }
+
+    bool operator >=(const basic_int_duration& compareTo) const
+    {
+        return value >= compareTo.value;
+    }
+
+    bool operator ==(TInt compareTo) const
+    {
+        return value == compareTo;
+    }
+
+    bool operator ==(const basic_int_duration& compareTo) const
+    {
+        return value == compareTo.value;
+    }
+
+    basic_int_duration& operator +=(const basic_int_duration& summand)
+    {
+        value += summand.value;
+        return *this;
+    }
+
+    basic_int_duration operator *(TInt multiplier) const
+    {
+        return basic_int_duration(value * multiplier);
+    }
+
+    basic_int_duration(TInt value) :
+        value(value)
+    {}
+};
+
+template <typename TInt>
+TInt operator /(
+        const basic_int_duration<TInt>& dividend,
+        const basic_int_duration<TInt>& divisor)
+{
+    return dividend.value / divisor.value;
+}
+
+template <typename TInt>
+basic_int_duration<TInt> operator -(
+        const basic_int_duration<TInt>& main,
+        const basic_int_duration<TInt>& subtrahend)
+{
+    return basic_int_duration<TInt>(main.value - subtrahend.value);
+}
+
+struct fake_clock
+{
+    typedef basic_int_duration<int> duration;
+    typedef duration time_point;
+};
+
+}}
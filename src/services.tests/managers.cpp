@@ -1,83 +1,258 @@
 #include "catch2/catch.hpp"
 
 #include <services/service.hpp>
+#include "services.h"
+#include "fake_clock.h"
 
+#include <atomic>
+#include <functional>
 #include <chrono>
+#include <memory>
+#include <stdexcept>
 
 #include <cstring>
+#include <ctime>
+
+#if __linux__
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
 
 using namespace moducom::services;
+using moducom::internal::fake_clock;
 
 #undef min
 
 typedef moducom::services::agents::Agent agent_type;
 
-// for scenarios where std::chrono::duration is a little more than we want
-template <class TInt>
-struct basic_int_duration
+template <typename TDuration>
+struct Periodic1 : ServiceBase
 {
-    TInt value;
+    typedef TDuration duration_type;
 
-    static constexpr basic_int_duration zero()
+    void run(duration_type interval)
     {
-        return basic_int_duration {0};
+
     }
+};
+
 
-    static constexpr basic_int_duration min()
+template <class TDuration = fake_clock::duration>
+struct PeriodicCounter : ServiceBase
+{
+    typedef TDuration duration_type;
+
+    std::atomic<int> counter = 0;
+    duration_type passed = duration_type::zero();
+
+    void run(duration_type passed)
     {
-        return basic_int_duration {-1};
+        ++counter;
+        this->passed = passed;
     }
+};
+
+
+// Notes the order in which it was run alongside others
+struct PeriodicRecorder : ServiceBase
+{
+    typedef fake_clock::duration duration_type;
+
+    std::vector<int>& log;
+    const int id;
 
-    bool operator >=(const basic_int_duration& compareTo) const
+    PeriodicRecorder(std::vector<int>& log, int id) : log(log), id(id) {}
+
+    void run(duration_type)
     {
-        return value >= compareTo.value;
+        log.push_back(id);
     }
+};
+
+
+// Runs whatever it's handed, for poking at the scheduler from within a run
+struct PeriodicCallback : ServiceBase
+{
+    typedef fake_clock::duration duration_type;
 
-    bool operator ==(TInt compareTo) const
+    std::function<void ()> f;
+
+    PeriodicCallback(std::function<void ()> f) : f(std::move(f)) {}
+
+    void run(duration_type)
     {
-        return value == compareTo;
+        f();
     }
+};
+
 
-    bool operator ==(const basic_int_duration& compareTo) const
+// Notes which thread it ran on, per whichever preference it's given
+template <ServiceBase::ThreadPreference preference>
+struct Placed : ServiceBase
+{
+    static constexpr ThreadPreference threadPreference() { return preference; }
+
+    std::thread::id ranOn;
+    std::atomic<int> counter = 0;
+
+    void run()
     {
-        return value == compareTo.value;
+        ranOn = std::this_thread::get_id();
+        ++counter;
     }
+};
+
+// Cooperative, and only wants running every 20ms
+struct PacedCooperative : ServiceBase
+{
+    static constexpr ThreadPreference threadPreference() { return ThreadPreference::PreferCooperative; }
+
+    std::atomic<int> counter = 0;
 
-    basic_int_duration& operator +=(const basic_int_duration& summand)
+    agents::Idle run()
     {
-        value += summand.value;
-        return *this;
+        ++counter;
+        return agents::Idle::after(std::chrono::milliseconds(20));
     }
+};
 
-    basic_int_duration(TInt value) :
-        value(value)
-    {}
+// Cooperative, and only wants running once woken
+struct WokenCooperative : ServiceBase
+{
+    static constexpr ThreadPreference threadPreference() { return ThreadPreference::PreferCooperative; }
+
+    std::atomic<int> counter = 0;
+
+    agents::Idle run()
+    {
+        ++counter;
+        return agents::Idle::woken();
+    }
 };
 
-template <typename TInt>
-basic_int_duration<TInt> operator -(
-        const basic_int_duration<TInt>& main,
-        const basic_int_duration<TInt>& subtrahend)
+#if FEATURE_MC_SERVICES_COROUTINE
+// Multi-step exchange, reading top to bottom as a coroutine
+struct Handshake : ServiceBase
 {
-    return basic_int_duration<TInt>(main.value - subtrahend.value);
-}
+    agents::coro::Channel<int> events;
+    agents::coro::Completion<int> transfer;
+
+    int received = 0;
+    int transferred = 0;
+    std::atomic<bool> waiting = false;
+    bool wokenByStop = false;
+    bool sawStop = false;
+
+    agents::coro::Task<> run()
+    {
+        using namespace std::chrono_literals;
+
+        co_await agents::coro::sleep_for(1ms);
 
+        received += *co_await events.next();
+        received += *co_await events.next();
+        transferred = *co_await transfer;
 
+        waiting = true;
+        wokenByStop = co_await agents::coro::sleep_for(1h);
 
-struct fake_clock
+        // Already stopped, so neither of these suspend
+        co_await agents::coro::stopped();
+        sawStop = (co_await agents::coro::token()).stop_requested();
+    }
+};
+
+// Parks on a channel nobody ever pushes to
+struct ParkedCoroutine : ServiceBase
 {
-    typedef basic_int_duration<int> duration;
-    typedef duration time_point;
+    agents::coro::Channel<int> events;
+    agents::coro::Completion<int> transfer;
+
+    std::atomic<bool> waiting = false;
+    bool gotEvent = true;
+    bool gotTransfer = true;
+
+    agents::coro::Task<> run()
+    {
+        waiting = true;
+        gotEvent = co_await events.next() != std::nullopt;
+        // Already stopped, so doesn't suspend
+        gotTransfer = co_await transfer != std::nullopt;
+    }
 };
+#endif
 
-template <typename TDuration>
-struct Periodic1 : ServiceBase
+// Simulates a long running periodic job
+template <class TDuration>
+struct PeriodicSlow : ServiceBase
 {
     typedef TDuration duration_type;
 
-    void run(duration_type interval)
+    std::atomic<int> counter = 0;
+
+    void run(duration_type)
+    {
+        using namespace std::chrono_literals;
+
+        std::this_thread::sleep_for(20ms);
+        ++counter;
+    }
+};
+
+// Overruns badly, holding up the rest of its shard
+template <class TDuration>
+struct PeriodicStuck : ServiceBase
+{
+    typedef TDuration duration_type;
+
+    std::atomic<bool> done = false;
+
+    void run(TDuration)
+    {
+        using namespace std::chrono_literals;
+
+        std::this_thread::sleep_for(300ms);
+        done = true;
+    }
+};
+
+// Notes when and where it ran, and whether 'stuck' had finished by then
+template <class TDuration>
+struct PeriodicStamp : ServiceBase
+{
+    typedef TDuration duration_type;
+
+    PeriodicStuck<TDuration>* stuck = nullptr;
+    std::thread::id thread;
+    std::atomic<bool> ran = false;
+    bool afterStuck = false;
+
+    void run(TDuration)
+    {
+        thread = std::this_thread::get_id();
+        afterStuck = stuck->done;
+        ran = true;
+    }
+};
+
+
+// Holds up whichever thread runs it until released
+template <class TDuration>
+struct PeriodicGate : ServiceBase
+{
+    typedef TDuration duration_type;
+
+    std::atomic<bool> entered = false;
+    std::atomic<bool> released = false;
+
+    void run(TDuration)
     {
+        using namespace std::chrono_literals;
 
+        entered = true;
+        while(!released) std::this_thread::sleep_for(1ms);
     }
 };
 
@@ -98,16 +273,221 @@ struct Continuous1 : ServiceBase
 
     Continuous1(int value) : value(value) {}
 
+    agents::Idle run()
+    {
+        using namespace std::chrono_literals;
+
+        return agents::Idle::after(100ms);
+    }
+};
+
+
+// Outlives the Flaky services it counts
+struct Crashes
+{
+    std::atomic<int> constructed {0};
+    // how many constructions throw from run()
+    int failures = 0;
+};
+
+
+// Throws from run() until constructed enough times
+struct Flaky : ServiceBase
+{
+    Crashes* const crashes;
+    const int generation;
+
+    Flaky(Crashes* crashes) :
+        crashes(crashes),
+        generation(++crashes->constructed)
+    {}
+
+    agents::Idle run()
+    {
+        if(generation <= crashes->failures) throw std::runtime_error("flaky");
+
+        return agents::Idle::woken();
+    }
+};
+
+
+// Throws from run() first time around, then from its constructor on the restart after
+struct Fragile : ServiceBase
+{
+    const int generation;
+
+    Fragile(Crashes* crashes) :
+        generation(++crashes->constructed)
+    {
+        if(generation == 2) throw std::runtime_error("fragile");
+    }
+
+    agents::Idle run()
+    {
+        if(generation == 1) throw std::runtime_error("fragile");
+
+        return agents::Idle::woken();
+    }
+};
+
+
+// Ignores stop requests for a while
+struct Stubborn : ServiceBase
+{
+    std::atomic<bool> entered = false;
+
     void run()
     {
         using namespace std::chrono_literals;
 
-        // DEBT: Need our own stop_source interruptable sleep
+        entered = true;
         std::this_thread::sleep_for(100ms);
     }
 };
 
 
+#if __linux__
+// Notes where and as what it finds itself running.  Kept apart from the service, which is
+// gone once stopped
+struct Observed
+{
+    char name[16] {};
+    cpu_set_t cpus;
+    std::atomic<bool> ran = false;
+};
+
+
+struct Introspect : ServiceBase
+{
+    static ThreadAttributes threadAttributes()
+    {
+        ThreadAttributes attributes;
+        attributes.name = "introspect";
+        return attributes;
+    }
+
+    Observed* const observed;
+
+    Introspect(Observed* observed) : observed(observed) {}
+
+    agents::Idle run()
+    {
+        pthread_getname_np(pthread_self(), observed->name, sizeof(observed->name));
+        pthread_getaffinity_np(pthread_self(), sizeof(observed->cpus), &observed->cpus);
+        observed->ran = true;
+        return agents::Idle::woken();
+    }
+};
+
+
+struct AlertRecorder
+{
+    std::vector<std::string> messages;
+
+    void alert(Agent*, Alert a)
+    {
+        messages.push_back(std::string(a.subsystem) + ": " + a.message);
+    }
+};
+#endif
+
+
+// Work queue drained by however many threads a pool gives it
+struct Jobs : ServiceBase
+{
+    static constexpr bool reentrant() { return true; }
+
+    std::atomic<int> pending;
+    std::atomic<int> done = 0;
+
+    Jobs(int pending) : pending(pending) {}
+
+    std::size_t backlog() const
+    {
+        int p = pending;
+        return p > 0 ? p : 0;
+    }
+
+    agents::Idle run()
+    {
+        using namespace std::chrono_literals;
+
+        if(pending.fetch_sub(1) <= 0)
+        {
+            ++pending;
+            return agents::Idle::after(1ms);
+        }
+
+        std::this_thread::sleep_for(1ms);
+        ++done;
+        return agents::Idle::busy();
+    }
+};
+
+
+// Busy in run() the whole time, one instance per pool member
+struct Grinder : ServiceBase
+{
+    std::atomic<int>* const live;
+
+    Grinder(std::atomic<int>* live) : live(live) { ++*live; }
+    ~Grinder() { --*live; }
+
+    // Spins rather than sleeps, since pool scales on CPU time
+    void run()
+    {
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+
+        while(std::chrono::steady_clock::now() < until);
+    }
+};
+
+
+// Always inside run(), though hardly ever on CPU
+struct Blocking : ServiceBase
+{
+    void run()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+};
+
+
+// Pool can't even get this off the ground
+struct SharedFails : ServiceBase
+{
+    static constexpr bool reentrant() { return true; }
+
+    SharedFails() { throw std::runtime_error("shared"); }
+
+    void run() {}
+};
+
+
+struct ScalingRecorder
+{
+    std::vector<agents::ScalingDecision> decisions;
+
+    void scaled(Agent*, agents::ScalingDecision d)
+    {
+        decisions.push_back(d);
+    }
+};
+
+
+// Does nothing until told to
+struct Parked : ServiceBase
+{
+    std::atomic<int> counter = 0;
+
+    agents::Idle run()
+    {
+        ++counter;
+        return agents::Idle::woken();
+    }
+};
+
+
 struct ScheduledRemoval : ServiceBase
 {
     typedef fake_clock::duration duration_type;
@@ -123,6 +503,15 @@ struct ScheduledRemoval : ServiceBase
 };
 
 
+struct Event1v2 : Event1
+{
+    static Description description()
+    {
+        return Description("event1", moducom::SemVer{0, 2, 0});
+    }
+};
+
+
 // we do this to test start/stop of Event1 -
 // if things go wrong, constructor doesn't even run - so we need
 // a global
@@ -142,6 +531,67 @@ struct Event2 : ServiceBase
 };
 
 
+static std::atomic<int> bulk_constructed {0};
+
+struct Bulk : ServiceBase
+{
+    static constexpr bool parallelConstruction() { return true; }
+
+    const int id;
+
+    Bulk(int id) : id(id) { ++bulk_constructed; }
+    ~Bulk() { --bulk_constructed; }
+};
+
+struct BulkFails : ServiceBase
+{
+    BulkFails() { throw std::runtime_error("bulk"); }
+};
+
+// Marks half of the bulk services, i.e. those attached to one device
+struct BulkTag {};
+
+
+struct Reading { int value; };
+struct Alarm { int code; };
+
+struct ReadingSum : ServiceBase
+{
+    int sum = 0;
+
+    void run(const Reading& r) { sum += r.value; }
+};
+
+// Queued, so takes its own copy
+struct ReadingLog : ServiceBase
+{
+    std::vector<int> values;
+
+    void run(Reading r) { values.push_back(r.value); }
+};
+
+struct AlarmCount : ServiceBase
+{
+    int count = 0;
+
+    void run(Alarm) { ++count; }
+};
+
+// Notes any reading handled off its owner's thread
+struct OwnedReadingSum : ServiceBase
+{
+    std::thread::id owner;
+    std::atomic<int> sum {0};
+    bool strayed = false;
+
+    void run(const Reading& r)
+    {
+        if(std::this_thread::get_id() != owner) strayed = true;
+        sum += r.value;
+    }
+};
+
+
 TEST_CASE("managers")
 {
     entt::registry registry;
@@ -150,34 +600,207 @@ TEST_CASE("managers")
     SECTION("semver")
     {
         //enttHelper.registry.get<moducom::SemVer>(enttHelper.entity);
+        typedef moducom::SemVer SemVer;
+
+        REQUIRE(SemVer{1, 2, 3} < SemVer{1, 3, 0});
+        REQUIRE(SemVer{1, 2, 3} == SemVer{1, 2, 3});
+        REQUIRE(SemVer{1, 2, 3, "alpha"} < SemVer{1, 2, 3});
+        REQUIRE(SemVer{1, 2, 3, "alpha"} < SemVer{1, 2, 3, "beta"});
+        REQUIRE(SemVer{2, 0, 0} > SemVer{1, 9, 9});
     }
     SECTION("aggregator")
     {
         agents::Aggregator a(enttHelper);
-    }
-    SECTION("scheduler")
-    {
-        /*
-        SECTION("basic")
+
+        SECTION("rollup")
         {
-            managers::Scheduler<int, int> scheduler;
+            EventGenerator generator;
+            agents::Event<Event1> agent1(enttHelper);
+            agents::Event<Event1> agent2(enttHelper);
+            agents::Event<Event1> agent3(enttHelper);
 
-            agents::Periodic<Periodic1<int> > agent1(1000);
+            a.add(agent1);
+            a.add(agent2);
 
-            scheduler.add(&agent1, 0);
+            REQUIRE(a.rollup().total() == 2);
+            REQUIRE(a.rollup().count(Status::Unstarted) == 2);
+            REQUIRE(a.overallStatus() == Status::Unstarted);
 
-            scheduler.run(100);
-        } */
-        SECTION("multiple")
-        {
-            managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler;
+            agent1.construct(generator);
 
-            agents::Periodic<Periodic1<fake_clock::duration> > agent1(enttHelper, 1000);
-            agents::Periodic<Periodic1<fake_clock::duration> > agent2(enttHelper, 1000);
-            agents::Periodic<Periodic1<fake_clock::duration> > agent3(enttHelper, 1000);
+            REQUIRE(a.rollup().count(Status::Waiting) == 1);
+            REQUIRE(a.overallStatus() == Status::Degraded);
 
-            scheduler.add(&agent1,0);
-            scheduler.add(&agent2, 500);
+            agent2.construct(generator);
+
+            REQUIRE(a.rollup().running() == 2);
+            REQUIRE(a.overallStatus() == Status::Waiting);
+
+            SECTION("nested")
+            {
+                agents::Aggregator child(enttHelper);
+
+                child.track(agent3);
+                a.addChild(child);
+
+                REQUIRE(a.rollup().total() == 3);
+                REQUIRE(a.overallStatus() == Status::Degraded);
+
+                agent3.construct(generator);
+
+                REQUIRE(child.overallStatus() == Status::Waiting);
+                REQUIRE(a.overallStatus() == Status::Waiting);
+
+                agent3.status(Status::Error);
+
+                REQUIRE(a.rollup().count(Status::Error) == 1);
+                REQUIRE(a.overallStatus() == Status::Error);
+
+                a.removeChild(child);
+
+                REQUIRE(a.rollup().total() == 2);
+                REQUIRE(a.overallStatus() == Status::Waiting);
+
+                agent3.destruct();
+            }
+
+            agent1.destruct();
+
+            REQUIRE(a.rollup().count(Status::Stopped) == 1);
+
+            agent2.destruct();
+
+            REQUIRE(a.overallStatus() == Status::Stopped);
+
+            a.clear();
+
+            REQUIRE(a.rollup().total() == 0);
+        }
+        SECTION("services")
+        {
+            typedef agents::Event<Event1> agent_type;
+
+            const entt::entity null = entt::null;
+            entt::entity e = a.createService<agent_type>();
+            agent_type& agent = a.getService<agent_type>(e);
+
+            REQUIRE(&a.getAgent(e) == &agent);
+            REQUIRE(a.rollup().total() == 1);
+
+            SECTION("batch")
+            {
+                std::vector<entt::entity> entities = a.createServices<agent_type>(1000);
+
+                REQUIRE(entities.size() == 1000);
+                REQUIRE(a.rollup().total() == 1001);
+
+                // Same chunk means neighbors in memory
+                REQUIRE(&a.getService<agent_type>(entities[1]) ==
+                    &a.getService<agent_type>(entities[0]) + 1);
+
+                int counter = 0;
+
+                a.eachService<agent_type>([&](entt::entity, agent_type&)
+                {
+                    ++counter;
+                });
+
+                REQUIRE(counter == 1001);
+
+                a.destroyService<agent_type>(entities[10]);
+
+                REQUIRE(a.rollup().total() == 1000);
+                REQUIRE(a.servicePool<agent_type>().size() == 1000);
+            }
+
+            SECTION("lookup")
+            {
+                typedef agents::Event<Event1v2> agent2_type;
+                typedef moducom::SemVer SemVer;
+
+                REQUIRE(a.findService("event1") == e);
+                REQUIRE(a.findService("event2") == null);
+                REQUIRE(a.findService<agent_type>() == e);
+                REQUIRE(a.findService<agent2_type>() == null);
+
+                entt::entity e2 = a.createService<agent2_type>();
+
+                REQUIRE(a.getAgent(e2).description().version() == SemVer{0, 2, 0});
+                REQUIRE(a.findService("event1") == e2);
+                REQUIRE(a.findService("event1", SemVer{0, 1, 0}, SemVer{0, 2, 0}) == e);
+                REQUIRE(a.findService("event1", SemVer{0, 1, 5}, SemVer{1, 0, 0}) == e2);
+                REQUIRE(a.findService("event1", SemVer{1, 0, 0}, SemVer{2, 0, 0}) == null);
+                REQUIRE(a.findService<agent2_type>() == e2);
+                // Same name, but e2 isn't an agent_type
+                REQUIRE(a.findService<agent_type>() == e);
+
+                a.destroyService<agent2_type>(e2);
+
+                REQUIRE(a.findService("event1") == e);
+                REQUIRE(a.findService<agent2_type>() == null);
+            }
+
+            a.destroyService<agent_type>(e);
+
+            REQUIRE(a.rollup().total() == a.servicePool<agent_type>().size());
+            REQUIRE(a.findService("event1") != e);
+        }
+        SECTION("stop")
+        {
+            agents::Aggregator child(enttHelper);
+            agents::Aggregator grandchild(enttHelper);
+            stop_token token = grandchild.stopToken();
+
+            a.addChild(child);
+            child.addChild(grandchild);
+
+            SECTION("subtree")
+            {
+                REQUIRE(a.requestStop());
+
+                REQUIRE(child.stopRequested());
+                REQUIRE(token.stop_requested());
+            }
+            SECTION("branch")
+            {
+                REQUIRE(child.requestStop());
+
+                REQUIRE(!a.stopRequested());
+                REQUIRE(token.stop_requested());
+            }
+            SECTION("removed")
+            {
+                a.removeChild(child);
+                a.requestStop();
+
+                REQUIRE(!child.stopRequested());
+                REQUIRE(!token.stop_requested());
+            }
+        }
+    }
+    SECTION("scheduler")
+    {
+        /*
+        SECTION("basic")
+        {
+            managers::Scheduler<int, int> scheduler;
+
+            agents::Periodic<Periodic1<int> > agent1(1000);
+
+            scheduler.add(&agent1, 0);
+
+            scheduler.run(100);
+        } */
+        SECTION("multiple")
+        {
+            managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler;
+
+            agents::Periodic<Periodic1<fake_clock::duration> > agent1(enttHelper, 1000);
+            agents::Periodic<Periodic1<fake_clock::duration> > agent2(enttHelper, 1000);
+            agents::Periodic<Periodic1<fake_clock::duration> > agent3(enttHelper, 1000);
+
+            scheduler.add(&agent1,0);
+            scheduler.add(&agent2, 500);
             scheduler.add(&agent3, 750);
 
             REQUIRE(scheduler.cfirst().wakeup == 0);
@@ -191,6 +814,560 @@ TEST_CASE("managers")
             scheduler.run(750);
             REQUIRE(scheduler.cfirst().wakeup == 1000);
         }
+        SECTION("wheel")
+        {
+            typedef agents::Periodic<PeriodicCounter<> > agent_type;
+            managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler;
+
+            agent_type agent1(enttHelper, 10);
+            agent_type agent2(enttHelper, 100000);
+
+            agent1.construct();
+            agent2.construct();
+
+            // lands a few levels up the wheel, so has to cascade down
+            scheduler.add(&agent2, 100000);
+            scheduler.add(&agent1, 5);
+
+            REQUIRE(scheduler.cfirst().wakeup == 5);
+
+            REQUIRE(scheduler.run(5));
+            REQUIRE(agent1.service().counter == 1);
+            REQUIRE(scheduler.cfirst().wakeup == 15);
+
+            REQUIRE(!scheduler.run(14));
+
+            // jumps a long way, agent1 gets one service per call
+            REQUIRE(scheduler.run(99999));
+            REQUIRE(agent1.service().counter == 2);
+            REQUIRE(agent2.service().counter == 0);
+
+            REQUIRE(scheduler.run(100000));
+            REQUIRE(agent2.service().counter == 1);
+            REQUIRE(scheduler.count() == 2);
+
+            // coarser resolution still expires at exact wakeup
+            SECTION("resolution")
+            {
+                managers::Scheduler<fake_clock::time_point, fake_clock::duration> coarse(64);
+                agent_type agent3(enttHelper, 10);
+
+                agent3.construct();
+
+                coarse.add(&agent3, 70);
+
+                REQUIRE(!coarse.run(69));
+                REQUIRE(coarse.run(70));
+                REQUIRE(coarse.cfirst().wakeup == 80);
+                REQUIRE(!coarse.run(79));
+                REQUIRE(coarse.run(80));
+
+                agent3.destruct();
+            }
+
+            agent1.destruct();
+            agent2.destruct();
+        }
+        SECTION("catch up")
+        {
+            typedef agents::Periodic<PeriodicCounter<> > agent_type;
+            managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler;
+
+            SECTION("drift free")
+            {
+                agent_type agent(enttHelper, 10);
+                agent.construct();
+
+                scheduler.add(&agent, 10, 0);
+
+                REQUIRE(scheduler.run(13));
+                REQUIRE(agent.service().passed == 13);
+                // lateness does not carry forward
+                REQUIRE(scheduler.cfirst().wakeup == 20);
+
+                REQUIRE(scheduler.run(21));
+                REQUIRE(agent.service().passed == 8);
+                REQUIRE(scheduler.cfirst().wakeup == 30);
+
+                agent.destruct();
+            }
+            SECTION("burst")
+            {
+                agent_type agent(enttHelper, 10, agents::CatchUp::Burst);
+                agent.construct();
+
+                scheduler.add(&agent, 0);
+                REQUIRE(scheduler.run(0));
+
+                // 10, 20 and 30 are all missed
+                REQUIRE(scheduler.run(35));
+                REQUIRE(agent.service().passed == 35);
+                REQUIRE(scheduler.run(35));
+                REQUIRE(agent.service().passed == 0);
+                REQUIRE(scheduler.run(35));
+                REQUIRE(!scheduler.run(35));
+                REQUIRE(agent.service().counter == 4);
+                REQUIRE(scheduler.cfirst().wakeup == 40);
+
+                agent.destruct();
+            }
+            SECTION("skip")
+            {
+                agent_type agent(enttHelper, 10, agents::CatchUp::Skip);
+                agent.construct();
+
+                scheduler.add(&agent, 0);
+                REQUIRE(scheduler.run(0));
+
+                REQUIRE(!scheduler.run(35));
+                REQUIRE(agent.service().counter == 1);
+                REQUIRE(scheduler.cfirst().wakeup == 40);
+
+                REQUIRE(scheduler.run(40));
+                REQUIRE(agent.service().counter == 2);
+                REQUIRE(agent.service().passed == 40);
+
+                // merely late, but not by a whole interval, still runs
+                REQUIRE(scheduler.run(55));
+                REQUIRE(agent.service().counter == 3);
+                REQUIRE(scheduler.cfirst().wakeup == 60);
+
+                // Always a whole interval behind.  Skips once, then runs and realigns
+                // rather than starving
+                REQUIRE(!scheduler.run(75));
+                REQUIRE(scheduler.cfirst().wakeup == 80);
+                REQUIRE(scheduler.run(95));
+                REQUIRE(agent.service().counter == 4);
+                REQUIRE(scheduler.cfirst().wakeup == 100);
+                REQUIRE(!scheduler.run(115));
+                REQUIRE(scheduler.run(135));
+                REQUIRE(agent.service().counter == 5);
+
+                agent.destruct();
+            }
+            SECTION("coalesce")
+            {
+                agent_type agent(enttHelper, 10, agents::CatchUp::Coalesce);
+                agent.construct();
+
+                scheduler.add(&agent, 0);
+                REQUIRE(scheduler.run(0));
+
+                REQUIRE(scheduler.run(35));
+                REQUIRE(agent.service().counter == 2);
+                REQUIRE(agent.service().passed == 35);
+                REQUIRE(!scheduler.run(35));
+                REQUIRE(scheduler.cfirst().wakeup == 40);
+
+                agent.destruct();
+            }
+        }
+        SECTION("expired by helper")
+        {
+            using namespace std::chrono_literals;
+
+            typedef managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler_type;
+
+            scheduler_type scheduler;
+            agents::Periodic<PeriodicGate<fake_clock::duration> > gate(enttHelper, 1000);
+            agents::Periodic<PeriodicCounter<> > agent1(enttHelper, 1000);
+            agents::Periodic<PeriodicCounter<> > agent2(enttHelper, 1000);
+
+            gate.construct();
+            agent1.construct();
+            agent2.construct();
+
+            scheduler.add(&gate, 100);
+            scheduler.add(&agent1, 105);
+            scheduler.add(&agent2, 105);
+
+            std::thread owner([&] { scheduler.run(100); });
+
+            // DEBT: Spinwaits are bad
+            while(!gate.service().entered) std::this_thread::sleep_for(1ms);
+
+            // Expires both as of 110, but services just one.  Owner, still on 100, picks
+            // up the other once released
+            bool helped = scheduler.run_ready(110);
+
+            gate.service().released = true;
+            owner.join();
+
+            scheduler_type::Statistics stats = scheduler.statistics();
+
+            REQUIRE(helped);
+            REQUIRE(agent1.service().counter == 1);
+            REQUIRE(agent2.service().counter == 1);
+            REQUIRE(stats.runs == 3);
+            REQUIRE(stats.lateness_total == fake_clock::duration(10));
+            REQUIRE(stats.lateness_max == fake_clock::duration(5));
+
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+            for(auto* agent : { &agent1, &agent2 })
+            {
+                scheduler_type::AgentStatistics agentStats;
+
+                REQUIRE(scheduler.statistics(agent, agentStats));
+                // 5 late lands in [4, 8), and nothing negative wrapped round to the top
+                REQUIRE(agentStats.lateness[3] == 1);
+                REQUIRE(agentStats.lateness[agentStats.lateness.buckets - 1] == 0);
+            }
+#endif
+
+            gate.destruct();
+            agent1.destruct();
+            agent2.destruct();
+        }
+        SECTION("histogram")
+        {
+            typedef agents::Periodic<PeriodicCounter<> > agent_type;
+            typedef managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler_type;
+
+            scheduler_type scheduler;
+            agent_type agent(enttHelper, 10);
+            agent.construct();
+
+            scheduler.add(&agent, 10);
+            scheduler.run(10);
+            scheduler.run(23);
+            scheduler.run(30);
+
+            scheduler_type::AgentStatistics stats;
+
+            REQUIRE(scheduler.statistics(&agent, stats));
+            REQUIRE(stats.lateness.count() == 3);
+            REQUIRE(stats.lateness[0] == 2);
+            // 3 late lands in [2, 4)
+            REQUIRE(stats.lateness[2] == 1);
+            REQUIRE(stats.lateness.quantile(0.5) == 0);
+            REQUIRE(stats.lateness.quantile(0.99) == 3);
+            REQUIRE(stats.runtime.count() == 3);
+
+            agent_type other(enttHelper, 10);
+            REQUIRE(!scheduler.statistics(&other, stats));
+
+            agent.destruct();
+        }
+        SECTION("handle")
+        {
+            typedef agents::Periodic<PeriodicCounter<> > agent_type;
+            typedef managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler_type;
+
+            scheduler_type scheduler;
+            agent_type agent1(enttHelper, 10);
+            agent_type agent2(enttHelper, 10);
+
+            agent1.construct();
+            agent2.construct();
+
+            scheduler_type::handle_type h1 = scheduler.add(&agent1, 10);
+            scheduler_type::handle_type h2 = scheduler.add(&agent2, 20);
+
+            REQUIRE(h1.pending());
+            REQUIRE(h1.cancel());
+            REQUIRE(!h1.pending());
+            REQUIRE(!h1.cancel());
+            REQUIRE(scheduler.count() == 1);
+            REQUIRE(!scheduler.run(10));
+
+            // node is recycled, but old handle stays stale
+            scheduler_type::handle_type h3 = scheduler.add(&agent1, 100);
+            REQUIRE(!h1.reschedule(5));
+            REQUIRE(h3.pending());
+
+            REQUIRE(h2.reschedule(15));
+            REQUIRE(scheduler.run(15));
+            REQUIRE(agent2.service().counter == 1);
+            REQUIRE(scheduler.cfirst().wakeup == 25);
+
+            // later, too
+            REQUIRE(h2.reschedule(50));
+            REQUIRE(!scheduler.run(49));
+            REQUIRE(scheduler.run(50));
+            REQUIRE(agent2.service().counter == 2);
+
+            SECTION("while running")
+            {
+                typedef agents::Periodic<PeriodicCallback> callback_type;
+                scheduler_type::handle_type h;
+                int runs = 0;
+
+                h2.cancel();
+                h3.cancel();
+
+                callback_type canceller(enttHelper, 10);
+                canceller.construct([&] { ++runs; h.cancel(); });
+
+                h = scheduler.add(&canceller, 60);
+                REQUIRE(scheduler.run(60));
+                REQUIRE(!h.pending());
+                REQUIRE(!scheduler.run(70));
+                REQUIRE(runs == 1);
+
+                callback_type mover(enttHelper, 10);
+                mover.construct([&] { ++runs; h.reschedule(1000); });
+
+                h = scheduler.add(&mover, 80);
+                REQUIRE(scheduler.run(80));
+                // rather than 90, as its interval says
+                REQUIRE(!scheduler.run(90));
+                REQUIRE(scheduler.run(1000));
+                REQUIRE(runs == 3);
+
+                canceller.destruct();
+                mover.destruct();
+            }
+
+            agent1.destruct();
+            agent2.destruct();
+        }
+        SECTION("priorities")
+        {
+            typedef agents::Periodic<PeriodicRecorder> agent_type;
+            typedef managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler_type;
+            typedef scheduler_type::priorities priorities;
+
+            scheduler_type scheduler;
+            std::vector<int> log;
+
+            agent_type housekeeping(enttHelper, 10);
+            agent_type safety(enttHelper, 10);
+            agent_type normal(enttHelper, 10);
+
+            housekeeping.construct(log, 3);
+            safety.construct(log, 1);
+            normal.construct(log, 2);
+
+            scheduler.add(&housekeeping, 10, priorities::idle);
+            scheduler.add(&normal, 10, priorities::medium);
+            scheduler.add(&safety, 10, priorities::highest);
+
+            REQUIRE(scheduler.run(10));
+            REQUIRE(log == std::vector<int>{1, 2, 3});
+
+            REQUIRE(scheduler.statistics(priorities::highest).runs == 1);
+            REQUIRE(scheduler.statistics(priorities::idle).runs == 1);
+            REQUIRE(scheduler.statistics(priorities::low).runs == 0);
+            REQUIRE(scheduler.statistics().runs == 3);
+
+            SECTION("aging")
+            {
+                agent_type late(enttHelper, 10);
+                late.construct(log, 4);
+
+                log.clear();
+                scheduler.aging(2);
+
+                // 18 late earns 9 bands, promoting it from idle to high: past
+                // medium though not past highest
+                scheduler.add(&late, 2, priorities::idle);
+                REQUIRE(scheduler.run(20));
+                REQUIRE(log == std::vector<int>{1, 4, 2, 3});
+
+                REQUIRE(scheduler.statistics(priorities::idle).lateness_max == 18);
+
+                late.destruct();
+            }
+            SECTION("strict")
+            {
+                log.clear();
+                scheduler.aging(0);
+
+                REQUIRE(scheduler.run(1000));
+                REQUIRE(log == std::vector<int>{1, 2, 3});
+            }
+
+            housekeeping.destruct();
+            safety.destruct();
+            normal.destruct();
+        }
+        SECTION("driver")
+        {
+            using namespace std::chrono_literals;
+
+            typedef managers::SchedulerDriver<> driver_type;
+            typedef agents::Periodic<PeriodicCounter<driver_type::duration_type> > agent_type;
+
+            driver_type driver(enttHelper);
+            stop_source source;
+            agent_type agent1(enttHelper, 1ms);
+
+            agent1.construct();
+
+            std::thread worker = driver.run(source.token());
+
+            // Starts out empty, so this add has to wake the driver
+            driver.add(&agent1);
+
+            auto start = std::chrono::steady_clock::now();
+
+            // DEBT: Spinwaits are bad
+            while(agent1.service().counter < 5 &&
+                std::chrono::steady_clock::now() - start < 5s)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+
+            REQUIRE(agent1.service().counter >= 5);
+
+            // Far off wakeup shouldn't delay stopping
+            agent_type agent2(enttHelper, 1h);
+            agent2.construct();
+            driver.add(&agent2, 1h);
+
+            start = std::chrono::steady_clock::now();
+            source.request_stop();
+            worker.join();
+
+            REQUIRE(std::chrono::steady_clock::now() - start < 1s);
+            REQUIRE(driver.status() == Status::Stopped);
+
+            agent1.destruct();
+            agent2.destruct();
+        }
+        SECTION("sharded")
+        {
+            using namespace std::chrono_literals;
+
+            typedef managers::ShardedScheduler<> scheduler_type;
+            typedef agents::Periodic<PeriodicSlow<scheduler_type::duration_type> > agent_type;
+
+            scheduler_type sharded(enttHelper, 2);
+            stop_source source;
+            std::vector<std::unique_ptr<agent_type> > agents;
+
+            REQUIRE(sharded.shardCount() == 2);
+
+            // Least loaded placement alternates between our two shards
+            for(int i = 0; i < 4; i++)
+            {
+                agents.emplace_back(new agent_type(enttHelper, 1h));
+                agents.back()->construct();
+                auto h = sharded.add(agents.back().get(), 1h);
+                REQUIRE(h.scheduler() == &sharded.scheduler(i % 2));
+            }
+
+            // Pile a few due right now onto shard 0 so that shard 1 has to help out
+            for(int i = 0; i < 4; i++)
+            {
+                agents.emplace_back(new agent_type(enttHelper, 1h));
+                agents.back()->construct();
+                sharded.scheduler(0).add(agents.back().get(),
+                                         std::chrono::steady_clock::now());
+            }
+
+            sharded.run(source.token());
+
+            auto start = std::chrono::steady_clock::now();
+
+            auto serviced = [&]
+            {
+                return sharded.statistics(0).runs;
+            };
+
+            // DEBT: Spinwaits are bad
+            while(serviced() < 4 && std::chrono::steady_clock::now() - start < 5s)
+                std::this_thread::sleep_for(1ms);
+
+            source.request_stop();
+            sharded.join();
+
+            auto stats0 = sharded.statistics(0);
+            auto stats1 = sharded.statistics(1);
+
+            REQUIRE(stats0.runs == 4);
+            REQUIRE(stats0.agents == 6);
+            REQUIRE(stats1.agents == 2);
+            REQUIRE(stats1.stolen > 0);
+            REQUIRE(stats0.stolen == 0);
+            REQUIRE(sharded.status() == Status::Stopped);
+
+            for(auto& agent : agents) agent->destruct();
+        }
+        SECTION("sharded overrun")
+        {
+            using namespace std::chrono_literals;
+
+            typedef managers::ShardedScheduler<> scheduler_type;
+            typedef scheduler_type::duration_type duration_type;
+
+            scheduler_type sharded(enttHelper, 2);
+            stop_source source;
+
+            agents::Periodic<PeriodicStuck<duration_type> > stuck(enttHelper, 1h);
+            agents::Periodic<PeriodicStamp<duration_type> > stamp(enttHelper, 1h);
+
+            stuck.construct();
+            stamp.construct();
+            stamp.service().stuck = &stuck.service();
+
+            auto now = std::chrono::steady_clock::now();
+
+            // Both on shard 0.  'stamp' only comes due once 'stuck' is well underway, so it
+            // was never waiting behind it in the backlog
+            sharded.scheduler(0).add(&stuck, now);
+            sharded.scheduler(0).add(&stamp, now + 50ms);
+
+            sharded.run(source.token());
+
+            // DEBT: Spinwaits are bad
+            while(!stamp.service().ran && std::chrono::steady_clock::now() - now < 5s)
+                std::this_thread::sleep_for(1ms);
+
+            source.request_stop();
+            sharded.join();
+
+            REQUIRE(stamp.service().ran);
+            REQUIRE(!stamp.service().afterStuck);
+            REQUIRE(sharded.statistics(1).stolen == 1);
+            REQUIRE(sharded.statistics(0).stolen == 0);
+
+            stuck.destruct();
+            stamp.destruct();
+        }
+        SECTION("sharded blocked")
+        {
+            using namespace std::chrono_literals;
+
+            typedef managers::ShardedScheduler<> scheduler_type;
+            typedef scheduler_type::duration_type duration_type;
+
+            scheduler_type sharded(enttHelper, 2);
+            stop_source source;
+
+            agents::Periodic<PeriodicGate<duration_type> > gate(enttHelper, 1h);
+            agents::Periodic<PeriodicCounter<duration_type> > counter(enttHelper, 1h);
+
+            gate.construct();
+            counter.construct();
+
+            sharded.run(source.token());
+
+            auto now = std::chrono::steady_clock::now();
+
+            // Shard 0's only agent, so its wheel holds nothing but a running item
+            sharded.scheduler(0).add(&gate, now);
+
+            // DEBT: Spinwaits are bad
+            while(!gate.service().entered) std::this_thread::sleep_for(1ms);
+
+            // Shard 1 runs this, then looks in on shard 0
+            sharded.scheduler(1).add(&counter, now);
+
+            while(counter.service().counter == 0 && std::chrono::steady_clock::now() - now < 5s)
+                std::this_thread::sleep_for(1ms);
+
+            std::this_thread::sleep_for(20ms);
+            gate.service().released = true;
+
+            source.request_stop();
+            sharded.join();
+
+            REQUIRE(counter.service().counter == 1);
+
+            gate.destruct();
+            counter.destruct();
+        }
         SECTION("real chrono")
         {
             using namespace std::chrono_literals;
@@ -207,35 +1384,301 @@ TEST_CASE("managers")
             scheduler.run(clock_type::time_point(300ms));
             REQUIRE(scheduler.cfirst().wakeup == clock_type::time_point(1200ms));
         }
-        SECTION("scheduled")
+        SECTION("scheduled")
+        {
+            managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler;
+
+            SECTION("basic")
+            {
+                agents::ScheduledRelative<Scheduled1> agent1(enttHelper);
+
+                scheduler.add(&agent1, 500);
+            }
+            SECTION("remover")
+            {
+                agents::ScheduledRelative<ScheduledRemoval> agent1(enttHelper);
+
+                agent1.construct();
+
+                scheduler.add(&agent1, 500);
+
+                scheduler.run(1000);
+                scheduler.run(2000);
+                REQUIRE(scheduler.count() == 1);
+                scheduler.run(3000);
+
+                REQUIRE(scheduler.count() == 0);
+
+                agent1.destruct();
+            }
+        }
+    }
+    SECTION("cooperative")
+    {
+        using namespace std::chrono_literals;
+        typedef ServiceBase::ThreadPreference preference;
+
+        typedef agents::SingleShot<Placed<preference::PreferCooperative> > coop_type;
+        typedef agents::SingleShot<Placed<preference::RequireThreaded> > own_type;
+        typedef agents::worker_t<Placed<preference::Default> > worker_type;
+        typedef agents::worker_t<Placed<preference::PreferThreaded> > preferred_type;
+
+        static_assert(!coop_type::threaded, "expected cooperative placement");
+        static_assert(own_type::threaded, "expected threaded placement");
+        static_assert(!worker_type::threaded, "expected cooperative placement");
+        static_assert(preferred_type::threaded == bool(FEATURE_MC_SERVICES_PREFERRED_THREADS),
+            "PreferThreaded only gets a thread when opted in");
+
+        managers::CooperativeExecutor<> executor(enttHelper);
+        stop_source source;
+
+        coop_type coop1(enttHelper), coop2(enttHelper);
+        own_type own(enttHelper);
+        worker_type worker(enttHelper);
+
+        coop1.construct();
+        coop2.construct();
+        own.construct();
+
+        executor.run(source.token());
+
+        executor.place(coop1, source.token());
+        executor.place(coop2, source.token());
+        executor.place(own, source.token());
+        executor.place(worker, source.token());
+
+        std::atomic<bool> posted = false;
+        executor.post([&] { posted = true; });
+
+        // DEBT: Spinwaits are bad
+        while(worker.status() != Status::Running || worker.service().counter < 3 || !posted)
+            std::this_thread::sleep_for(1ms);
+
+        source.request_stop();
+        executor.join();
+
+        REQUIRE(executor.threadCount() == 1);
+        REQUIRE(coop1.service().ranOn == executor.threadId());
+        REQUIRE(coop2.service().ranOn == executor.threadId());
+        REQUIRE(own.service().ranOn != executor.threadId());
+        REQUIRE(own.service().counter == 1);
+        REQUIRE(coop1.status() == Status::Stopped);
+        REQUIRE(worker.status() == Status::Stopped);
+        REQUIRE(executor.status() == Status::Stopped);
+
+        coop1.destruct();
+        coop2.destruct();
+        own.destruct();
+    }
+    SECTION("cooperative idle")
+    {
+        using namespace std::chrono_literals;
+
+        typedef agents::worker_t<PacedCooperative> paced_type;
+        typedef agents::worker_t<WokenCooperative> woken_type;
+
+        static_assert(!paced_type::threaded, "expected cooperative placement");
+
+        managers::CooperativeExecutor<> executor(enttHelper);
+        stop_source source;
+
+        paced_type paced(enttHelper);
+        woken_type woken(enttHelper);
+
+        executor.run(source.token());
+
+        executor.place(paced, source.token());
+        executor.place(woken, source.token());
+
+        // DEBT: Spinwaits are bad
+        while(woken.status() != Status::Running || woken.service().counter < 1)
+            std::this_thread::sleep_for(1ms);
+
+        // Both idle, so executor thread should be too
+        std::clock_t cpu = std::clock();
+        std::this_thread::sleep_for(200ms);
+        cpu = std::clock() - cpu;
+
+        woken.wake();
+
+        while(woken.service().counter < 2) std::this_thread::sleep_for(1ms);
+
+        source.request_stop();
+        executor.join();
+
+        // Spinning would have burned most of the 200ms
+        REQUIRE(cpu < CLOCKS_PER_SEC / 20);
+        // Every 20ms over roughly 200ms, give or take
+        REQUIRE(paced.service().counter >= 5);
+        REQUIRE(paced.service().counter <= 20);
+        REQUIRE(woken.service().counter == 2);
+        REQUIRE(paced.status() == Status::Stopped);
+        REQUIRE(woken.status() == Status::Stopped);
+    }
+#if FEATURE_MC_SERVICES_REACTOR
+    SECTION("reactor")
+    {
+        using namespace std::chrono_literals;
+        typedef managers::Reactor reactor_type;
+
+        reactor_type reactor(enttHelper);
+        stop_source source;
+
+        // Two services' worth of file descriptors sharing one thread
+        int fds1[2], fds2[2];
+        std::atomic<int> received1 {0}, received2 {0};
+        std::thread::id ranOn;
+
+        REQUIRE(pipe2(fds1, O_NONBLOCK | O_CLOEXEC) == 0);
+        REQUIRE(pipe2(fds2, O_NONBLOCK | O_CLOEXEC) == 0);
+
+        auto reader = [&](int fd, std::atomic<int>& received)
+        {
+            return [&, fd](unsigned)
+            {
+                char buf[16];
+                ssize_t n;
+
+                ranOn = std::this_thread::get_id();
+
+                while((n = read(fd, buf, sizeof(buf))) > 0) received += n;
+            };
+        };
+
+        reactor.add(fds1[0], reactor_type::readable, reader(fds1[0], received1));
+        reactor.add(fds2[0], reactor_type::readable, reader(fds2[0], received2));
+
+        REQUIRE(reactor.size() == 2);
+        REQUIRE_THROWS_AS(reactor.add(fds1[0], reactor_type::readable, [](unsigned) {}),
+                          std::system_error);
+
+        reactor.run(source.token());
+
+        REQUIRE(write(fds1[1], "hello", 5) == 5);
+        REQUIRE(write(fds2[1], "hi", 2) == 2);
+
+        // DEBT: Spinwaits are bad
+        while(received1 < 5 || received2 < 2)
+            std::this_thread::sleep_for(1ms);
+
+        SECTION("remove")
+        {
+            reactor.remove(fds1[0]);
+
+            REQUIRE(reactor.size() == 1);
+            REQUIRE(write(fds1[1], "ignored", 7) == 7);
+
+            std::atomic<bool> posted = false;
+            reactor.post([&] { posted = true; });
+
+            // DEBT: Spinwaits are bad
+            while(!posted) std::this_thread::sleep_for(1ms);
+
+            REQUIRE(received1 == 5);
+        }
+
+        // Nothing pending and no timeout, so only the stop request's wake gets us out
+        auto start = std::chrono::steady_clock::now();
+
+        source.request_stop();
+        reactor.join();
+
+        REQUIRE(std::chrono::steady_clock::now() - start < 50ms);
+        REQUIRE(ranOn == reactor.threadId());
+        REQUIRE(reactor.status() == Status::Stopped);
+
+        for(int fd : { fds1[0], fds1[1], fds2[0], fds2[1] }) close(fd);
+    }
+#endif
+#if FEATURE_MC_SERVICES_COROUTINE
+    SECTION("coroutine")
+    {
+        using namespace std::chrono_literals;
+        typedef agents::Coroutine<Handshake> coroutine_type;
+
+        constexpr int count = 100;
+
+        managers::CooperativeExecutor<> executor(enttHelper);
+        stop_source source;
+        std::vector<std::unique_ptr<coroutine_type> > agents;
+
+        executor.run(source.token());
+
+        for(int i = 0; i < count; ++i)
+        {
+            agents.emplace_back(new coroutine_type(enttHelper));
+            coroutine_type& a = *agents.back();
+
+            a.construct();
+            executor.spawn(a, source.token());
+            REQUIRE(a.status() == Status::Running);
+        }
+
+        // Arrives whether or not each coroutine is awaiting yet
+        for(int i = 0; i < count; ++i)
+        {
+            Handshake& s = agents[i]->service();
+
+            s.events.push(i);
+            std::thread([&s, i] { s.events.push(1); s.transfer.complete(i * 2); }).join();
+        }
+
+        // DEBT: Spinwaits are bad
+        for(auto& a : agents)
+            while(!a->service().waiting) std::this_thread::sleep_for(1ms);
+
+        source.request_stop();
+        executor.join();
+
+        // 100 coroutines, still only the one thread
+        REQUIRE(executor.threadCount() == 0);
+
+        for(int i = 0; i < count; ++i)
         {
-            managers::Scheduler<fake_clock::time_point, fake_clock::duration> scheduler;
+            coroutine_type& a = *agents[i];
+            Handshake& s = a.service();
+
+            REQUIRE(a.done());
+            REQUIRE(!a.error());
+            REQUIRE(a.status() == Status::Stopped);
+            REQUIRE(s.received == i + 1);
+            REQUIRE(s.transferred == i * 2);
+            REQUIRE(s.wokenByStop);
+            REQUIRE(s.sawStop);
+        }
 
-            SECTION("basic")
-            {
-                agents::ScheduledRelative<Scheduled1> agent1(enttHelper);
+        for(auto& a : agents) a->destruct();
+    }
+    SECTION("coroutine parked")
+    {
+        using namespace std::chrono_literals;
+        typedef agents::Coroutine<ParkedCoroutine> coroutine_type;
 
-                scheduler.add(&agent1, 500);
-            }
-            SECTION("remover")
-            {
-                agents::ScheduledRelative<ScheduledRemoval> agent1(enttHelper);
+        managers::CooperativeExecutor<> executor(enttHelper);
+        stop_source source;
+        coroutine_type a(enttHelper);
 
-                agent1.construct();
+        executor.run(source.token());
 
-                scheduler.add(&agent1, 500);
+        a.construct();
+        executor.spawn(a, source.token());
 
-                scheduler.run(1000);
-                scheduler.run(2000);
-                REQUIRE(scheduler.count() == 1);
-                scheduler.run(3000);
+        // DEBT: Spinwaits are bad
+        while(!a.service().waiting) std::this_thread::sleep_for(1ms);
+        std::this_thread::sleep_for(5ms);
 
-                REQUIRE(scheduler.count() == 0);
+        // Would hang here if stop didn't reach channel
+        source.request_stop();
+        executor.join();
 
-                agent1.destruct();
-            }
-        }
+        REQUIRE(a.done());
+        REQUIRE(!a.error());
+        REQUIRE(!a.service().gotEvent);
+        REQUIRE(!a.service().gotTransfer);
+
+        a.destruct();
     }
+#endif
     SECTION("standalone")
     {
         auto s = agents::make_standalone<Continuous1>(enttHelper, 1);
@@ -276,6 +1719,307 @@ TEST_CASE("managers")
 
             REQUIRE(s.status() == Status::Stopped);
         }
+        SECTION("idle")
+        {
+            using namespace std::chrono_literals;
+            typedef std::chrono::steady_clock clock;
+
+            auto p = agents::make_standalone<Parked>(enttHelper);
+            stop_source source;
+
+            std::thread worker = p.run(source.token());
+
+            // DEBT: Spinwaits are bad
+            while(p.service().counter == 0)
+                std::this_thread::sleep_for(1ms);
+
+            // Parked, so not called again until woken
+            std::this_thread::sleep_for(20ms);
+            REQUIRE(p.service().counter == 1);
+
+            p.wake();
+
+            while(p.service().counter == 1)
+                std::this_thread::sleep_for(1ms);
+
+            REQUIRE(p.service().counter == 2);
+
+            auto start = clock::now();
+            source.request_stop();
+            worker.join();
+
+            // Nowhere near a sleeping service's usual turnaround
+            REQUIRE(clock::now() - start < 50ms);
+            REQUIRE(p.status() == Status::Stopped);
+
+            agents::WorkerStatistics statistics = p.statistics();
+
+            REQUIRE(statistics.iterations == 2);
+            REQUIRE(statistics.idle >= 20ms);
+            REQUIRE(statistics.utilisation() < 0.5);
+        }
+        SECTION("statistics")
+        {
+            using namespace std::chrono_literals;
+
+            auto p = agents::make_standalone<Placed<ServiceBase::ThreadPreference::Default> >(enttHelper);
+            stop_source source;
+
+            std::thread worker = p.run(source.token());
+
+            // Readable while running, without holding anyone up
+            while(p.statistics().iterations < 1000)
+                std::this_thread::sleep_for(1ms);
+
+            source.request_stop();
+            worker.join();
+
+            agents::WorkerStatistics statistics = p.statistics();
+
+            REQUIRE(statistics.iterations >= 1000);
+            // Never parks, so all of it is busy
+            REQUIRE(statistics.idle.count() == 0);
+            REQUIRE(statistics.utilisation() == 1);
+            REQUIRE(statistics.busy.count() > 0);
+            REQUIRE(statistics.cpu.count() > 0);
+        }
+        SECTION("pool")
+        {
+            using namespace std::chrono_literals;
+            typedef std::chrono::steady_clock clock;
+
+            agents::PoolPolicy policy;
+            stop_source source;
+            ScalingRecorder recorder;
+
+            policy.interval = 5ms;
+
+            SECTION("shared")
+            {
+                policy.maximum = 4;
+
+                auto pool = agents::make_worker_pool<Jobs>(enttHelper, policy, 200);
+
+                pool.scalingSink.connect<&ScalingRecorder::scaled>(recorder);
+
+                std::thread worker = pool.run(source.token());
+
+                // DEBT: Spinwaits are bad
+                while(pool.status() != Status::Running) std::this_thread::sleep_for(1ms);
+
+                unsigned largest = 0;
+
+                // Backlog grows pool to its limit
+                while(pool.service().done < 200)
+                {
+                    largest = std::max(largest, pool.size());
+                    std::this_thread::sleep_for(1ms);
+                }
+
+                REQUIRE(largest == 4);
+
+                // Then, with nothing to do, it shrinks back down
+                auto deadline = clock::now() + 2s;
+                while(pool.size() > 1 && clock::now() < deadline)
+                    std::this_thread::sleep_for(1ms);
+
+                REQUIRE(pool.size() == 1);
+
+                source.request_stop();
+                worker.join();
+
+                REQUIRE(pool.status() == Status::Stopped);
+                REQUIRE(pool.size() == 0);
+                REQUIRE(pool.statistics().iterations >= 200);
+                REQUIRE(recorder.decisions.front().from == 0);
+                REQUIRE(recorder.decisions.front().to == 1);
+                REQUIRE(recorder.decisions.front().backlog == 200);
+                REQUIRE(recorder.decisions.back().to == 1);
+            }
+            SECTION("per member")
+            {
+                std::atomic<int> live = 0;
+
+                policy.minimum = 2;
+                policy.maximum = 3;
+
+                auto pool = agents::make_worker_pool<Grinder>(enttHelper, policy, &live);
+
+                pool.scalingSink.connect<&ScalingRecorder::scaled>(recorder);
+
+                std::thread worker = pool.run(source.token());
+
+                // Always busy, so grows straight to its limit
+                while(pool.size() < 3 || live < 3) std::this_thread::sleep_for(1ms);
+
+                source.request_stop();
+                worker.join();
+
+                REQUIRE(live == 0);
+                REQUIRE(recorder.decisions.size() == 2);
+                REQUIRE(recorder.decisions[0].to == 2);
+                REQUIRE(recorder.decisions[1].utilisation > policy.scaleUp);
+                REQUIRE(recorder.decisions[1].to == 3);
+            }
+            SECTION("blocking")
+            {
+                policy.maximum = 3;
+
+                auto pool = agents::make_worker_pool<Blocking>(enttHelper, policy);
+
+                pool.scalingSink.connect<&ScalingRecorder::scaled>(recorder);
+
+                std::thread worker = pool.run(source.token());
+
+                // Plenty of intervals for it to wrongly grow in
+                std::this_thread::sleep_for(100ms);
+
+                unsigned size = pool.size();
+
+                source.request_stop();
+                worker.join();
+
+                REQUIRE(size == 1);
+                // Just the initial one up to minimum
+                REQUIRE(recorder.decisions.size() == 1);
+                REQUIRE(pool.statistics().utilisation() > policy.scaleUp);
+                REQUIRE(pool.statistics().cpuUtilisation() < policy.scaleDown);
+            }
+            SECTION("construct throws")
+            {
+                SECTION("per member")
+                {
+                    Crashes crashes;
+
+                    auto pool = agents::make_worker_pool<Fragile>(enttHelper, policy, &crashes);
+
+                    std::thread worker = pool.run(source.token());
+
+                    // run() throws, then constructor does, then third time lucky
+                    auto deadline = clock::now() + 2s;
+                    while((crashes.constructed < 3 || pool.size() < 1) && clock::now() < deadline)
+                        std::this_thread::sleep_for(1ms);
+
+                    source.request_stop();
+                    worker.join();
+
+                    REQUIRE(crashes.constructed == 3);
+                    REQUIRE(pool.status() == Status::Stopped);
+                }
+                SECTION("shared")
+                {
+                    auto pool = agents::make_worker_pool<SharedFails>(enttHelper, policy);
+
+                    std::thread worker = pool.run(source.token());
+
+                    worker.join();
+
+                    REQUIRE(pool.status() == Status::Error);
+                    REQUIRE(pool.size() == 0);
+                }
+            }
+        }
+#if __linux__
+        SECTION("thread attributes")
+        {
+            using namespace std::chrono_literals;
+
+            Observed observed;
+            auto agent = agents::make_standalone<Introspect>(enttHelper, &observed);
+            stop_source source;
+            AlertRecorder recorder;
+
+            agent.alertSink.connect<&AlertRecorder::alert>(recorder);
+
+            SECTION("declared")
+            {
+                std::thread worker = agent.run(source.token());
+
+                // DEBT: Spinwaits are bad
+                while(!observed.ran) std::this_thread::sleep_for(1ms);
+
+                source.request_stop();
+                worker.join();
+
+                REQUIRE(std::string(observed.name) == "introspect");
+                REQUIRE(recorder.messages.empty());
+            }
+            SECTION("configured")
+            {
+                ThreadAttributes attributes;
+                attributes.cpus = { 0 };
+                attributes.name = "a very long name indeed";
+                agent.threadAttributes(attributes);
+
+                std::thread worker = agent.run(source.token());
+
+                while(!observed.ran) std::this_thread::sleep_for(1ms);
+
+                source.request_stop();
+                worker.join();
+
+                // Linux truncates to 15
+                REQUIRE(std::string(observed.name) == "a very long nam");
+                REQUIRE(CPU_COUNT(&observed.cpus) == 1);
+                REQUIRE(CPU_ISSET(0, &observed.cpus));
+            }
+            SECTION("failure")
+            {
+                ThreadAttributes attributes;
+                attributes.policy = ThreadAttributes::Policy::Fifo;
+                attributes.priority = 1000;         // well out of range
+                attributes.name = "still named";
+                agent.threadAttributes(attributes);
+
+                std::thread worker = agent.run(source.token());
+
+                while(!observed.ran) std::this_thread::sleep_for(1ms);
+
+                source.request_stop();
+                worker.join();
+
+                // Reported, yet agent carries on regardless
+                REQUIRE(recorder.messages.size() == 1);
+                REQUIRE(recorder.messages[0].rfind("thread: SCHED_FIFO", 0) == 0);
+                REQUIRE(std::string(observed.name) == "still named");
+                REQUIRE(agent.status() == Status::Stopped);
+            }
+            SECTION("numa")
+            {
+                namespace numa = moducom::internal::numa;
+
+                std::vector<unsigned> local = numa::cpus(0);
+
+                ThreadAttributes attributes;
+                attributes.node = 0;
+                agent.threadAttributes(attributes);
+
+                std::thread worker = agent.run(source.token());
+
+                while(!observed.ran) std::this_thread::sleep_for(1ms);
+
+                for(int i = 0; i < 3; ++i) agent.wake();
+
+                NumaPlacement placement = agent.placement();
+
+                source.request_stop();
+                worker.join();
+
+                REQUIRE(placement.thread == 0);
+                REQUIRE(placement.local + placement.remote == 3);
+                // Memory policy syscalls are commonly refused inside containers
+                REQUIRE(placement.memory <= 0);
+                for(const std::string& m : recorder.messages)
+                    REQUIRE(m.rfind("thread: memory policy", 0) == 0);
+
+                // Kernel built without NUMA has no node directory to speak of
+                if(!local.empty())
+                    for(unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                        if(CPU_ISSET(cpu, &observed.cpus))
+                            REQUIRE(std::find(local.begin(), local.end(), cpu) != local.end());
+            }
+        }
+#endif
         SECTION("manager")
         {
             managers::StandaloneStdThreadManager manager(enttHelper);
@@ -287,7 +2031,249 @@ TEST_CASE("managers")
             // FIX: If we don't stop(), some thread-related errors occur here mainly complaining
             // from entt, likely because entt registry itself goes out of scope before thread
             // does -- though I really don't recall interacting with registry on shutdown that much
-            manager.stop();
+            auto report = manager.stop();
+
+            REQUIRE(report.agents.size() == 1);
+            REQUIRE(report.count(managers::Shutdown::Stopped) == 1);
+
+            SECTION("parallel")
+            {
+                using namespace std::chrono_literals;
+
+                managers::StandaloneStdThreadManager manager2(enttHelper);
+
+                for(int i = 0; i < 8; ++i)
+                    manager2.push<Continuous1>(10 + i).start();
+
+                manager2.push_and_start<Parked>();
+                // Never started, so nothing to wait on
+                manager2.push<Parked>();
+
+                // Each started one runs at least once before parking.
+                // DEBT: Spinwaits are bad
+                while(manager2.statistics().total.iterations < 9)
+                    std::this_thread::sleep_for(1ms);
+
+                // Idle services wake on stop rather than seeing out their 100ms
+                report = manager2.stop();
+
+                REQUIRE(report.agents.size() == 10);
+                REQUIRE(report.count(managers::Shutdown::Stopped) == 10);
+
+                auto statistics = manager2.statistics();
+
+                REQUIRE(statistics.agents.size() == 10);
+                REQUIRE(statistics.total.iterations >= 9);
+                REQUIRE(statistics.agents.back().second.iterations == 0);
+
+                auto placements = manager2.placements();
+
+                REQUIRE(placements.size() == 10);
+                // Never started, so never placed
+                REQUIRE(placements.back().second.thread == -1);
+                REQUIRE(report.duration < 50ms);
+            }
+            SECTION("timeout")
+            {
+                using namespace std::chrono_literals;
+
+                managers::StandaloneStdThreadManager manager2(enttHelper);
+
+                manager2.push<Continuous1>(1).start();
+                auto stubborn = manager2.push<Stubborn>();
+                stubborn.start();
+
+                // DEBT: Spinwaits are bad
+                while(stubborn.agent().status() != Status::Running ||
+                      !stubborn.agent().service().entered)
+                    std::this_thread::sleep_for(1ms);
+
+                report = manager2.stop(10ms);
+
+                REQUIRE(report.count(managers::Shutdown::Stopped) == 1);
+                REQUIRE(report.count(managers::Shutdown::TimedOut) == 1);
+                REQUIRE(report.duration >= 10ms);
+
+                // Thread was kept, so a second attempt may yet succeed
+                report = manager2.stop();
+
+                REQUIRE(report.count(managers::Shutdown::Stopped) == 2);
+            }
+            SECTION("branch")
+            {
+                using namespace std::chrono_literals;
+
+                managers::StandaloneStdThreadManager root(enttHelper);
+                // i.e. everything attached to one USB device
+                managers::StandaloneStdThreadManager device1(enttHelper);
+                managers::StandaloneStdThreadManager device2(enttHelper);
+
+                root.addChild(device1);
+                root.addChild(device2);
+
+                auto rootToken = root.push<Parked>();
+                auto device1Token = device1.push<Parked>();
+                auto device2Token = device2.push<Parked>();
+
+                rootToken.start();
+                device1Token.start();
+                device2Token.start();
+
+                // DEBT: Spinwaits are bad
+                while(root.statistics().total.iterations < 1 ||
+                      device1.statistics().total.iterations < 1 ||
+                      device2.statistics().total.iterations < 1)
+                    std::this_thread::sleep_for(1ms);
+
+                // Draining one branch leaves its parent and siblings be
+                report = device1.stop();
+
+                REQUIRE(report.count(managers::Shutdown::Stopped) == 1);
+                REQUIRE(!root.stopRequested());
+                REQUIRE(!device2.stopRequested());
+                REQUIRE(rootToken.agent().status() == Status::Running);
+                REQUIRE(device2Token.agent().status() == Status::Running);
+
+                // Whereas stopping the parent reaches the whole subtree
+                report = root.stop();
+
+                REQUIRE(report.count(managers::Shutdown::Stopped) == 1);
+                REQUIRE(device2.stopRequested());
+
+                report = device2.stop();
+
+                REQUIRE(report.count(managers::Shutdown::Stopped) == 1);
+            }
+            SECTION("supervision")
+            {
+                using namespace std::chrono_literals;
+
+                typedef managers::Supervision::Strategy strategy;
+
+                managers::StandaloneStdThreadManager manager2(enttHelper);
+                managers::Supervision supervision;
+                Crashes crashes, peerCrashes;
+
+                auto flaky = manager2.push<Flaky>(&crashes);
+                auto peer = manager2.push<Flaky>(&peerCrashes);
+
+                peer.start();
+
+                // DEBT: Spinwaits are bad
+                while(peer.agent().status() != Status::Running) std::this_thread::sleep_for(1ms);
+
+                SECTION("none")
+                {
+                    crashes.failures = 1;
+                    flaky.start();
+
+                    while(flaky.agent().status() != Status::Error) std::this_thread::sleep_for(1ms);
+
+                    report = manager2.stop();
+
+                    REQUIRE(manager2.restarts() == 0);
+                    REQUIRE(report.count(managers::Shutdown::Failed) == 1);
+                    REQUIRE(report.count(managers::Shutdown::Stopped) == 1);
+                }
+                SECTION("one for one")
+                {
+                    supervision.strategy = strategy::OneForOne;
+                    manager2.supervise(supervision);
+
+                    crashes.failures = 2;
+                    flaky.start();
+
+                    while(crashes.constructed < 3 || flaky.agent().status() != Status::Running)
+                        std::this_thread::sleep_for(1ms);
+
+                    report = manager2.stop();
+
+                    REQUIRE(manager2.restarts() == 2);
+                    // Left well alone
+                    REQUIRE(peerCrashes.constructed == 1);
+                    REQUIRE(report.count(managers::Shutdown::Stopped) == 2);
+                }
+                SECTION("one for all")
+                {
+                    supervision.strategy = strategy::OneForAll;
+                    manager2.supervise(supervision);
+
+                    crashes.failures = 1;
+                    flaky.start();
+
+                    while(crashes.constructed < 2 || peerCrashes.constructed < 2 ||
+                          flaky.agent().status() != Status::Running ||
+                          peer.agent().status() != Status::Running)
+                        std::this_thread::sleep_for(1ms);
+
+                    report = manager2.stop();
+
+                    REQUIRE(manager2.restarts() == 1);
+                    REQUIRE(report.count(managers::Shutdown::Stopped) == 2);
+                }
+                SECTION("intensity")
+                {
+                    supervision.strategy = strategy::OneForOne;
+                    supervision.intensity = 2;
+                    supervision.backoff = 5ms;
+                    manager2.supervise(supervision);
+
+                    crashes.failures = 100;
+
+                    auto start = std::chrono::steady_clock::now();
+
+                    flaky.start();
+
+                    while(flaky.agent().status() != Status::Error) std::this_thread::sleep_for(1ms);
+
+                    // 5ms, then 10ms
+                    REQUIRE(std::chrono::steady_clock::now() - start >= 15ms);
+
+                    report = manager2.stop();
+
+                    REQUIRE(crashes.constructed == 3);
+                    REQUIRE(manager2.restarts() == 2);
+                    REQUIRE(report.count(managers::Shutdown::Failed) == 1);
+                }
+                SECTION("stop during backoff")
+                {
+                    supervision.strategy = strategy::OneForOne;
+                    supervision.backoff = 10s;
+                    supervision.maxBackoff = 10s;
+                    manager2.supervise(supervision);
+
+                    crashes.failures = 1;
+                    flaky.start();
+
+                    while(manager2.restarts() == 0) std::this_thread::sleep_for(1ms);
+
+                    report = manager2.stop();
+
+                    REQUIRE(report.duration < 1s);
+                    REQUIRE(report.count(managers::Shutdown::Stopped) == 2);
+                    REQUIRE(crashes.constructed == 1);
+                }
+                SECTION("constructor throws on restart")
+                {
+                    supervision.strategy = strategy::OneForOne;
+                    manager2.supervise(supervision);
+
+                    Crashes fragileCrashes;
+                    auto fragile = manager2.push<Fragile>(&fragileCrashes);
+
+                    fragile.start();
+
+                    while(fragileCrashes.constructed < 3 ||
+                          fragile.agent().status() != Status::Running)
+                        std::this_thread::sleep_for(1ms);
+
+                    report = manager2.stop();
+
+                    REQUIRE(manager2.restarts() == 2);
+                    // Never started 'flaky' included
+                    REQUIRE(report.count(managers::Shutdown::Stopped) == 3);
+                }
+            }
         }
     }
     SECTION("event")
@@ -324,5 +2310,135 @@ TEST_CASE("managers")
 
             REQUIRE(event2_signal == 4);
         }
+        SECTION("bulk")
+        {
+            constexpr int count = 1000;
+
+            for(int i = 0; i < count; ++i) manager.push_exp<Bulk>(i);
+            auto failing = manager.push_exp<BulkFails>();
+
+            int i = 0;
+            for(entt::entity e : registry2.view<ServiceToken*>())
+                if(i++ % 2) registry2.emplace<BulkTag>(e);
+
+            auto tagged = registry2.view<BulkTag>();
+            auto filter = [&](entt::entity e) { return tagged.contains(e); };
+
+            REQUIRE(manager.start_exp(filter) == count / 2);
+            REQUIRE(bulk_constructed == count / 2);
+
+            // Already started ones are left be
+            REQUIRE(manager.start_exp() == count / 2);
+            REQUIRE(bulk_constructed == count);
+            REQUIRE(failing->agent().status() == Status::Error);
+
+            // Arguments made it to each one
+            long sum = 0;
+            for(entt::entity e : registry2.view<ServiceToken*>())
+            {
+                auto token = dynamic_cast<managers::internal::EventTokenExp<
+                    agents::Event<Bulk>, int>*>(registry2.get<ServiceToken*>(e));
+
+                if(token != nullptr)
+                {
+                    REQUIRE(token->agent().status() == Status::Waiting);
+                    sum += token->agent().service().id;
+                }
+            }
+            REQUIRE(sum == count * (count - 1) / 2);
+
+            REQUIRE(manager.stop_exp(filter) == count / 2);
+            REQUIRE(bulk_constructed == count / 2);
+            REQUIRE(manager.stop_exp() == count / 2);
+            REQUIRE(bulk_constructed == 0);
+        }
+        SECTION("bus")
+        {
+            managers::EventBus<Reading, Alarm> bus;
+
+            agents::Event<ReadingSum> sum(enttHelper);
+            agents::AsyncEventQueue<ReadingLog> log(enttHelper);
+            agents::Event<AlarmCount> alarms(enttHelper);
+
+            sum.construct();
+            log.construct();
+            alarms.construct();
+
+            // Synchronous and queued subscribers side by side
+            bus.subscribe(sum);
+            bus.subscribe(log);
+            bus.subscribe(alarms);
+
+            REQUIRE(bus.subscribers<Reading>() == 2);
+            REQUIRE(bus.subscribers<Alarm>() == 1);
+
+            bus.publish(Reading{1});
+            bus.publish(Reading{2});
+            bus.publish(Alarm{404});
+
+            // Synchronous ones have it already
+            REQUIRE(sum.service().sum == 3);
+            REQUIRE(alarms.service().count == 1);
+
+            log.wait();
+
+            REQUIRE(log.service().values == std::vector<int>{1, 2});
+
+            REQUIRE(bus.unsubscribe(sum));
+            REQUIRE(!bus.unsubscribe(sum));
+
+            bus.publish(Reading{3});
+            log.wait();
+
+            REQUIRE(sum.service().sum == 3);
+            REQUIRE(log.service().values.size() == 3);
+
+            sum.destruct();
+            log.destruct();
+            alarms.destruct();
+        }
+        SECTION("owned")
+        {
+            using namespace std::chrono_literals;
+            typedef managers::CooperativeExecutor<> executor_type;
+
+            // Enough per producer to span several mailbox blocks
+            constexpr int producers = 4;
+            constexpr int count = 1000;
+
+            executor_type executor(enttHelper);
+            agents::OwnedEvent<OwnedReadingSum, executor_type> event(enttHelper, executor);
+            stop_source source;
+
+            event.construct();
+            executor.run(source.token());
+            event.service().owner = executor.threadId();
+
+            std::vector<std::thread> threads;
+
+            for(int i = 0; i < producers; ++i)
+                threads.emplace_back([&]
+                {
+                    for(int j = 0; j < count; ++j) event.run(Reading{1});
+                });
+
+            for(std::thread& t : threads) t.join();
+
+            // DEBT: Spinwaits are bad
+            while(event.service().sum != producers * count) std::this_thread::sleep_for(1ms);
+
+            // From owner's own thread it runs right away
+            executor.post([&] { event.run(Reading{1}); });
+
+            while(event.service().sum != producers * count + 1) std::this_thread::sleep_for(1ms);
+
+            REQUIRE(event.producers() == producers);
+            REQUIRE(!event.service().strayed);
+
+            source.request_stop();
+            executor.join();
+
+            event.destruct();
+        }
     }
 }
\ No newline at end of file
@@ -57,6 +57,162 @@ TEST_CASE("misc")
 
             REQUIRE(called_back);
         }
+        SECTION("after stop")
+        {
+            REQUIRE(s.request_stop());
+            REQUIRE(!s.request_stop());
+
+            bool called_back = false;
+
+            stop_callback c(s.token(), [&] { called_back = true; });
+
+            REQUIRE(called_back);
+        }
+        SECTION("deregister")
+        {
+            int called_back = 0;
+
+            {
+                stop_callback c(s.token(), [&] { ++called_back; });
+            }
+            stop_callback c(s.token(), [&] { ++called_back; });
+
+            s.request_stop();
+
+            REQUIRE(called_back == 1);
+        }
+        SECTION("lifetime")
+        {
+            stop_token t = s.token();
+
+            REQUIRE(t.stop_possible());
+
+            SECTION("stopped")
+            {
+                s.request_stop();
+                s = stop_source(nostopstate);
+
+                REQUIRE(t.stop_requested());
+                REQUIRE(t.stop_possible());
+            }
+            SECTION("abandoned")
+            {
+                stop_source copy = s;
+
+                s = stop_source(nostopstate);
+                REQUIRE(t.stop_possible());
+
+                copy = stop_source(nostopstate);
+                REQUIRE(!t.stop_requested());
+                REQUIRE(!t.stop_possible());
+
+                bool called_back = false;
+                stop_callback c(t, [&] { called_back = true; });
+                REQUIRE(!called_back);
+            }
+        }
+        SECTION("linked")
+        {
+            stop_source child(s.token());
+            stop_source grandchild(child.token());
+            stop_token t = grandchild.token();
+            bool called_back = false;
+
+            stop_callback c(t, [&] { called_back = true; });
+
+            SECTION("parent")
+            {
+                s.request_stop();
+
+                REQUIRE(child.stop_requested());
+                REQUIRE(called_back);
+            }
+            SECTION("child")
+            {
+                child.request_stop();
+
+                REQUIRE(!s.stop_requested());
+                REQUIRE(called_back);
+            }
+            SECTION("unlinked")
+            {
+                grandchild.unlink();
+                s.request_stop();
+
+                REQUIRE(child.stop_requested());
+                REQUIRE(!called_back);
+            }
+            SECTION("parent stopped already")
+            {
+                s.request_stop();
+
+                stop_source late(s.token());
+
+                REQUIRE(late.stop_requested());
+            }
+            SECTION("outlives parent")
+            {
+                // Link alone keeps children stoppable
+                grandchild = stop_source(nostopstate);
+
+                REQUIRE(t.stop_possible());
+
+                s = stop_source(nostopstate);
+                child.request_stop();
+
+                REQUIRE(called_back);
+            }
+            SECTION("destroyed during stop")
+            {
+                // Child may go away while parent is propagating into it, and must
+                // then be deleted exactly once
+                for(int i = 0; i < 1000; ++i)
+                {
+                    stop_source parent;
+                    std::optional<stop_source> doomed(std::in_place, parent.token());
+                    std::atomic<bool> ready {false}, go {false};
+
+                    std::thread destroyer([&]
+                    {
+                        ready = true;
+                        while(!go);
+                        doomed.reset();
+                    });
+
+                    // Both sides set off as close together as we can manage
+                    while(!ready) std::this_thread::yield();
+                    go = true;
+                    parent.request_stop();
+                    destroyer.join();
+
+                    REQUIRE(parent.stop_requested());
+                }
+            }
+        }
+        SECTION("concurrent")
+        {
+            constexpr int count = 8;
+            std::atomic<int> called_back {0};
+            std::vector<std::thread> threads;
+
+            for(int i = 0; i < count; ++i)
+                threads.emplace_back([&]
+                {
+                    for(int j = 0; j < 100; ++j)
+                        stop_callback c(s.token(), [&] { ++called_back; });
+
+                    // whichever side of request_stop this lands on, it gets called
+                    stop_callback c(s.token(), [&] { ++called_back; });
+
+                    while(!s.stop_requested()) std::this_thread::yield();
+                });
+
+            s.request_stop();
+
+            for(std::thread& t : threads) t.join();
+
+            REQUIRE(called_back >= count);
+        }
     }
     SECTION("Agent")
     {
@@ -163,5 +319,99 @@ TEST_CASE("misc")
                 REQUIRE(!std::is_reference_v<std::tuple_element<0, tuple_type>::type>);
             }
         }
+        SECTION("numa")
+        {
+            namespace numa = moducom::internal::numa;
+
+            SECTION("parse_list")
+            {
+                std::vector<unsigned> v = numa::parse_list("0-3,8,10-11\n");
+
+                REQUIRE(v == std::vector<unsigned>{ 0, 1, 2, 3, 8, 10, 11 });
+                REQUIRE(numa::parse_list("").empty());
+            }
+            SECTION("allocator")
+            {
+                // Node 0 always exists, whether or not the kernel lets us bind to it
+                numa::Allocator<int> allocator(0);
+                std::vector<int, numa::Allocator<int> > v(allocator);
+                std::deque<int, numa::Allocator<int> > d(allocator);
+
+                REQUIRE(allocator.node() == 0);
+
+                // Grows well past the largest size class, into mappings of its own
+                for(int i = 0; i < 100000; ++i)
+                {
+                    v.push_back(i);
+                    d.push_back(i);
+                }
+
+                REQUIRE(v[99999] == 99999);
+                REQUIRE(d.front() == 0);
+
+                d.clear();
+                d.shrink_to_fit();
+                // Freed blocks come back around
+                d.assign(1000, 7);
+                REQUIRE(d.back() == 7);
+
+                // Without a node, it's just the free store
+                std::vector<int, numa::Allocator<int> > v2(3, 1);
+                REQUIRE(v2.get_allocator().node() == -1);
+            }
+        }
+        SECTION("SpscQueue")
+        {
+            moducom::internal::SpscQueue<std::string, 4> q;
+            std::string out;
+
+            REQUIRE(q.empty());
+            REQUIRE(!q.pop(out));
+
+            // Crosses a few block boundaries, twice over so spare blocks come back around
+            for(int round = 0; round < 2; ++round)
+            {
+                for(int i = 0; i < 10; ++i) q.push(std::to_string(i));
+
+                for(int i = 0; i < 10; ++i)
+                {
+                    REQUIRE(q.pop(out));
+                    REQUIRE(out == std::to_string(i));
+                }
+
+                REQUIRE(q.empty());
+            }
+
+            SECTION("concurrent")
+            {
+                constexpr int count = 10000;
+                long sum = 0;
+                int expected = 0;
+                bool ordered = true;
+
+                std::thread producer([&]
+                {
+                    for(int i = 0; i < count; ++i) q.emplace(std::to_string(i));
+                });
+
+                for(int received = 0; received < count;)
+                {
+                    if(!q.consume([&](std::string& s)
+                    {
+                        int v = std::stoi(s);
+                        if(v != expected++) ordered = false;
+                        sum += v;
+                    })) continue;
+
+                    ++received;
+                }
+
+                producer.join();
+
+                REQUIRE(ordered);
+                REQUIRE(sum == long(count) * (count - 1) / 2);
+                REQUIRE(q.empty());
+            }
+        }
     }
 }
\ No newline at end of file
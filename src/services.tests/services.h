@@ -32,6 +32,11 @@ struct Event1 : moducom::services::ServiceBase
     }
 
 
+    static moducom::services::Description description()
+    {
+        return moducom::services::Description("event1", moducom::SemVer{0, 1, 0});
+    }
+
     ~Event1()
     {
         //std::clog << "Got here" << std::endl;
@@ -12,15 +12,37 @@
 #include <entt/entt.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <future>
+#include <list>
+#include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 
 #include "moducom/stop_token.h"
 #include "moducom/services/agent.h"
 #include "moducom/internal/argtype.h"
+#include "moducom/internal/chunked_pool.h"
+#include "moducom/internal/numa.h"
+#include "moducom/internal/sleeper.h"
+#include "moducom/internal/spsc.h"
+
+// Threads go only to services which RequireThreaded; PreferThreaded ones share the
+// cooperative executor.  When set, PreferThreaded services get a thread of their own too
+#ifndef FEATURE_MC_SERVICES_PREFERRED_THREADS
+#define FEATURE_MC_SERVICES_PREFERRED_THREADS 0
+#endif
 
 namespace moducom { namespace services { namespace agents {
 
@@ -119,27 +141,186 @@ public:
 };
 
 
+namespace internal {
+
+template <class TService>
+auto service_name(int) -> decltype(TService::description().name())
+{
+    return TService::description().name();
+}
+
+/// TService has no description()
+template <class TService>
+const char* service_name(...) { return nullptr; }
+
+template <class TService>
+auto backlog(TService& service, int) -> decltype(std::size_t(service.backlog()))
+{
+    return service.backlog();
+}
+
+/// TService has no backlog()
+template <class TService>
+std::size_t backlog(TService&, ...) { return 0; }
+
+/// Placed on each entity created via Aggregator::createService
+struct ServiceSlot
+{
+    Agent* agent;
+    std::size_t index;      ///< where in its ServicePool the service lives
+};
+
+/// By-value, contiguous storage for all services of one type.  Lives in the
+/// Aggregator's registry context
+template <class TService>
+struct ServicePool : moducom::internal::ChunkedPool<TService>
+{
+    /// Owning entity, indexed by slot
+    std::vector<entt::entity> entities;
+};
+
+}
+
+
 class Aggregator :
         public Agent,
         // TODO: Decouple this and make Depender 1:1 with entity since both Aggregator (root taxonomy)
         // and regular agent can both have dependencies
         public Depender
 {
-    void dependentStatus()
+    // Last known status of each directly tracked agent, so that we can back out
+    // the old status when a new one arrives
+    std::unordered_map<const Agent*, Status> tracked_;
+    std::vector<Aggregator*> children_;
+    Aggregator* parent_ = nullptr;
+
+    // Guards tracked_ and rollup_, since agents publish status from their own threads.
+    // Deltas travel child to parent with the child's lock held, so always lock in that order.
+    // Agents' own status signals are another matter, which is why track() and friends insist
+    // on agents which aren't running
+    mutable std::mutex mutex_;
+    StatusRollup rollup_;
+    entt::sigh<void (Status, int)> rollupSignal_;
+
+    // Linked beneath parent's, so that stopping any aggregator reaches its whole subtree
+    stop_source stopSource_;
+
+    // Services we created, bucketed by interned (hashed) name and kept highest version first
+    std::unordered_map<entt::id_type, std::vector<entt::entity> > byName_;
+
+    void indexService(entt::entity entity)
+    {
+        const Description& d = registry.get<Description>(entity);
+        std::vector<entt::entity>& bucket = byName_[entt::hashed_string::value(d.name())];
+
+        auto i = std::find_if(bucket.begin(), bucket.end(), [&](entt::entity e)
+        {
+            return registry.get<Description>(e).version() < d.version();
+        });
+
+        bucket.insert(i, entity);
+    }
+
+    void unindexService(entt::entity entity)
+    {
+        const Description& d = registry.get<Description>(entity);
+        auto i = byName_.find(entt::hashed_string::value(d.name()));
+        std::vector<entt::entity>& bucket = i->second;
+
+        bucket.erase(std::find(bucket.begin(), bucket.end(), entity));
+
+        if(bucket.empty()) byName_.erase(i);
+    }
+
+    /// \param predicate bool(entt::entity, const Description&)
+    template <class F>
+    entt::entity findByName(const char* name, F&& predicate) const
+    {
+        auto i = byName_.find(entt::hashed_string::value(name));
+
+        if(i == byName_.end()) return entt::null;
+
+        for(entt::entity e : i->second)
+        {
+            const Description& d = registry.get<Description>(e);
+
+            // strcmp guards against hash collisions
+            if(std::strcmp(d.name(), name) == 0 && predicate(e, d))
+                return e;
+        }
+
+        return entt::null;
+    }
+
+    /// Whether 'agent' is past or yet to begin publishing status from a thread of its own.
+    /// Only then may its statusSink be connected or disconnected, since entt::sigh
+    /// doesn't guard against that happening alongside publish()
+    static bool quiescent(const Agent& agent)
+    {
+        Status s = agent.status();
+
+        return s == Status::Unstarted || s == Status::Stopped || s == Status::Error;
+    }
+
+    // Expects mutex_ held
+    void rollupAdjust(Status status, int delta)
     {
+        rollup_.adjust(status, delta);
+        rollupSignal_.publish(status, delta);
+    }
 
+    void childRollup(Status status, int delta)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rollupAdjust(status, delta);
     }
 
-    void dependentProgress()
+    void dependentStatus(Agent* agent, Status status)
     {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto i = tracked_.find(agent);
 
+        // Untracked while this publish was on its way
+        if(i == tracked_.end() || i->second == status) return;
+
+        // Two-step (remove then add) so that parents see the same deltas we do
+        rollupAdjust(i->second, -1);
+        i->second = status;
+        rollupAdjust(status, 1);
+    }
+
+    // Expects mutex_ held
+    void adjustAll(const StatusRollup& rollup, int sign)
+    {
+        for(unsigned i = 0; i < status_count; ++i)
+        {
+            auto s = static_cast<Status>(i);
+            int c = rollup.count(s);
+            if(c > 0) rollupAdjust(s, sign * c);
+        }
     }
 
 public:
     Aggregator(EnttHelper eh) :
-        Agent(eh)
+        Agent(eh),
+        rollupSink{rollupSignal_}
     {}
 
+    ~Aggregator()
+    {
+        if(parent_ != nullptr) parent_->removeChild(*this);
+
+        while(!children_.empty())
+            removeChild(*children_.back());
+
+        clear();
+    }
+
+    /// Fires with (status, delta) every time our (nested) tally changes
+    /// NOTE: Handlers run under our lock, so mustn't call back into this aggregator
+    entt::sink<void (Status, int)> rollupSink;
+
     // DEBT: Resolve this with depender's vector
     // DEBT: Exposing this as publis is a no-no
     entt::registry registry;
@@ -154,26 +335,268 @@ public:
         status(Status::Stopping);
     }
 
+    /// Begin counting 'agent' towards our status rollup (but not as a dependency)
+    /// NOTE: Only before 'agent' starts, or once it has stopped.  Status it publishes while
+    /// running is fine, but connecting to it then is not
+    void track(Agent& agent)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if(tracked_.count(&agent)) return;
+
+        assert(quiescent(agent));
+
+        Status s = agent.status();
+        tracked_.emplace(&agent, s);
+        agent.statusSink.connect<&Aggregator::dependentStatus>(*this);
+        rollupAdjust(s, 1);
+    }
+
+    /// NOTE: As with track(), only while 'agent' isn't running
+    void untrack(Agent& agent)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto i = tracked_.find(&agent);
+
+        if(i == tracked_.end()) return;
+
+        assert(quiescent(agent));
+
+        agent.statusSink.disconnect<&Aggregator::dependentStatus>(*this);
+        rollupAdjust(i->second, -1);
+        tracked_.erase(i);
+    }
+
+    /// Adds 'agent' both as a dependency and towards our status rollup
+    void add(agent_type& agent)
+    {
+        Depender::add(agent);
+        track(agent);
+    }
+
+    /// NOTE: As with untrack(), only while none of our agents are running
+    void clear()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            for(auto& i : tracked_)
+            {
+                assert(quiescent(*i.first));
+
+                // DEBT: const_cast needed since sink wants a mutable instance, even though
+                // disconnect doesn't really touch it
+                auto agent = const_cast<Agent*>(i.first);
+                agent->statusSink.disconnect<&Aggregator::dependentStatus>(*this);
+                rollupAdjust(i.second, -1);
+            }
+
+            tracked_.clear();
+        }
+        Depender::clear();
+    }
+
+    /// Nest 'child' aggregator's rollup into ours
+    void addChild(Aggregator& child)
+    {
+        if(child.parent_ != nullptr) child.parent_->removeChild(child);
+
+        std::lock_guard<std::mutex> childLock(child.mutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        child.parent_ = this;
+        children_.push_back(&child);
+        child.rollupSink.connect<&Aggregator::childRollup>(*this);
+        adjustAll(child.rollup_, 1);
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        child.stopSource_.link(stopSource_.token());
+#endif
+    }
+
+    void removeChild(Aggregator& child)
+    {
+        auto i = std::find(children_.begin(), children_.end(), &child);
+
+        if(i == children_.end()) return;
+
+        std::lock_guard<std::mutex> childLock(child.mutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        child.rollupSink.disconnect<&Aggregator::childRollup>(*this);
+        adjustAll(child.rollup_, -1);
+        children_.erase(i);
+        child.parent_ = nullptr;
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        child.stopSource_.unlink();
+#endif
+    }
+
+    /// Snapshot tally of all agents tracked by us and our child aggregators, O(1)
+    StatusRollup rollup() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return rollup_;
+    }
+
+    /// Overall health of this aggregator's whole subtree, O(1)
+    Status overallStatus() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return rollup_.overall();
+    }
+
+    /// Hand this to agents which belong to us.  Stopped by our requestStop() or by that of
+    /// any aggregator above us
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+    stop_token stopToken() const { return stopSource_.token(); }
+#else
+    const stop_token& stopToken() const { return stopSource_.token(); }
+#endif
+
+    /// Stops agents run with our token or that of any child aggregator, leaving the rest
+    /// of the tree alone.  O(subtree), and runs their stop callbacks on calling thread
+    /// \return false if stop was already requested
+    bool requestStop() { return stopSource_.request_stop(); }
+
+    bool stopRequested() const { return stopSource_.stop_requested(); }
+
+    template <class TService>
+    internal::ServicePool<TService>& servicePool()
+    {
+        auto pool = registry.try_ctx<internal::ServicePool<TService> >();
+        return pool != nullptr ? *pool : registry.set<internal::ServicePool<TService> >();
+    }
+
+private:
     template <class TService, class ...TArgs>
-    entt::entity createService(TArgs&&...args)
+    TService& emplaceService(internal::ServicePool<TService>& pool, entt::entity entity,
+                             TArgs&&...args)
     {
-        entt::entity entity = registry.create();
         EnttHelper eh(registry, entity);
-        auto service = new TService(eh, std::forward<TArgs>(args)...);
+        std::size_t index = pool.emplace(eh, std::forward<TArgs>(args)...);
+        TService& service = pool[index];
+
+        if(pool.entities.size() <= index)
+            pool.entities.resize(index + 1, entt::null);
+
+        pool.entities[index] = entity;
 
         registry.emplace<Description>(entity, TService::description());
-        registry.emplace<std::unique_ptr<TService> >(entity, service);
+        registry.emplace<internal::ServiceSlot>(entity, &service, index);
+
+        indexService(entity);
+        track(service);
+
+        return service;
+    }
+
+public:
+    template <class TService, class ...TArgs>
+    entt::entity createService(TArgs&&...args)
+    {
+        entt::entity entity = registry.create();
 
-        // FIX: Experimental, having this and unique ptr at same time
-        registry.emplace<Agent*>(entity, service);
+        emplaceService<TService>(servicePool<TService>(), entity, std::forward<TArgs>(args)...);
 
         return entity;
     }
 
+    /// Creates 'n' services of type TService all constructed with the same 'args'
+    /// @details Reserves storage up front so that the batch lands contiguously
+    template <class TService, class ...TArgs>
+    std::vector<entt::entity> createServices(std::size_t n, const TArgs&...args)
+    {
+        auto& pool = servicePool<TService>();
+        std::vector<entt::entity> entities(n);
+
+        pool.reserve(pool.size() + n);
+        pool.entities.reserve(pool.size() + n);
+        registry.reserve<Description, internal::ServiceSlot>(registry.size<internal::ServiceSlot>() + n);
+        registry.create(entities.begin(), entities.end());
+
+        for(entt::entity entity : entities)
+            emplaceService<TService>(pool, entity, args...);
+
+        return entities;
+    }
+
+    template <class TService>
+    void destroyService(entt::entity entity)
+    {
+        auto& pool = servicePool<TService>();
+        std::size_t index = registry.get<internal::ServiceSlot>(entity).index;
+
+        untrack(pool[index]);
+        unindexService(entity);
+        pool.entities[index] = entt::null;
+        pool.erase(index);
+        registry.destroy(entity);
+    }
+
     template <class TService>
     TService& getService(entt::entity entity)
     {
-        return *registry.get<std::unique_ptr<TService> >(entity).get();
+        auto& slot = registry.get<internal::ServiceSlot>(entity);
+
+        // DEBT: We trust the caller on TService, but at least sanity check it in debug builds
+        assert(&servicePool<TService>()[slot.index] == slot.agent);
+
+        return static_cast<TService&>(*slot.agent);
+    }
+
+    Agent& getAgent(entt::entity entity)
+    {
+        return *registry.get<internal::ServiceSlot>(entity).agent;
+    }
+
+    /// Finds highest version service registered under 'name', O(1)
+    /// \return entity of service, or entt::null if none found
+    entt::entity findService(const char* name) const
+    {
+        return findByName(name, [](entt::entity, const Description&) { return true; });
+    }
+
+    /// Finds highest version service registered under 'name' within [min, max)
+    /// \return entity of service, or entt::null if none found
+    entt::entity findService(const char* name, const SemVer& min, const SemVer& max) const
+    {
+        return findByName(name, [&](entt::entity, const Description& d)
+        {
+            return min <= d.version() && d.version() < max;
+        });
+    }
+
+    /// Finds first TService we own, via the name index like findService(name), O(1)
+    /// @details Services of other types may share TService's name, so only those living in
+    /// TService's own pool count
+    /// \return entity of service, or entt::null if none found
+    template <class TService>
+    entt::entity findService()
+    {
+        auto pool = registry.try_ctx<internal::ServicePool<TService> >();
+
+        if(pool == nullptr) return entt::null;
+
+        return findByName(TService::description().name(), [&](entt::entity e, const Description&)
+        {
+            std::size_t index = registry.get<internal::ServiceSlot>(e).index;
+
+            return index < pool->entities.size() && pool->entities[index] == e;
+        });
+    }
+
+    /// Visits every TService we own, sequentially through (mostly) contiguous memory
+    /// \param f invoked as f(entt::entity, TService&)
+    template <class TService, class F>
+    void eachService(F&& f)
+    {
+        auto& pool = servicePool<TService>();
+
+        pool.each([&](std::size_t index, TService& service)
+        {
+            f(pool.entities[index], service);
+        });
     }
 };
 
@@ -218,189 +641,1152 @@ class Base :
 {
     typedef Container<TService> container_base;
 
-public:
-    typedef TService service_type;
+public:
+    typedef TService service_type;
+
+protected:
+    typedef service_type& reference;
+
+public:
+    Base(EnttHelper entity) : Agent(entity) {}
+
+    reference service()
+    {
+        return container_base::contained();
+    }
+
+    static Description description()
+    {
+        return service_type::description();
+    }
+
+    using Agent::threadAttributes;
+
+    /// As configured for this agent, otherwise as TService declares.  Named after TService
+    /// when not named already
+    ThreadAttributes threadAttributes() const
+    {
+        const ThreadAttributes* configured = Agent::configuredThreadAttributes();
+        ThreadAttributes attributes = configured ? *configured : service_type::threadAttributes();
+
+        if(attributes.name.empty())
+        {
+            const char* name = internal::service_name<service_type>(0);
+            attributes.name = name != nullptr ? name : Agent::threadAttributes().name;
+        }
+
+        return attributes;
+    }
+
+    /// As Agent::placement(), plus which node backs the service
+    NumaPlacement placement()
+    {
+        NumaPlacement p = Agent::placement();
+
+        p.memory = moducom::internal::numa::of(&service());
+        return p;
+    }
+
+    template <class ... TArgs>
+    void construct(TArgs&&...args)
+    {
+        Agent::status(Status::Starting);
+        container_base::construct(std::forward<TArgs>(args)...);
+        Agent::status(Status::Started);
+    }
+};
+
+/// Whether TService gets a thread of its own, per its threadPreference().  Only
+/// RequireThreaded does by default (see FEATURE_MC_SERVICES_PREFERRED_THREADS).  Everything
+/// else is placed on a shared cooperative executor
+template <class TService>
+constexpr bool needs_thread()
+{
+    typedef ServiceBase::ThreadPreference preference;
+
+    return TService::threadPreference() == preference::RequireThreaded ||
+        (FEATURE_MC_SERVICES_PREFERRED_THREADS &&
+         TService::threadPreference() == preference::PreferThreaded);
+}
+
+/// Runs service once
+/// @details Threaded flavor exposes run(stop_token) returning a std::thread, cooperative
+/// flavor exposes step(stop_token) for an executor to call from its own thread.
+/// 'threaded' tells them apart at compile time
+template <class TService, bool = needs_thread<TService>()>
+class SingleShot;
+
+template <class TService>
+class SingleShot<TService, true> : public Base<TService>
+{
+    typedef Base<TService> base_type;
+    typedef SingleShot this_type;
+
+    void worker(ThreadAttributes attributes)
+    {
+        base_type::applyThreadAttributes(attributes);
+        base_type::status(Status::Running);
+        base_type::service().run();
+        base_type::status(Status::Stopped);
+    }
+
+public:
+    static constexpr bool threaded = true;
+
+    SingleShot(EnttHelper eh) : base_type(eh) {}
+
+    /// NOTE: Service runs to completion regardless of token
+    std::thread run(const stop_token&)
+    {
+        return std::thread(&this_type::worker, this, base_type::threadAttributes());
+    }
+};
+
+template <class TService>
+class SingleShot<TService, false> : public Base<TService>
+{
+    typedef Base<TService> base_type;
+
+public:
+    static constexpr bool threaded = false;
+
+    SingleShot(EnttHelper eh) : base_type(eh) {}
+
+    /// Runs service right here, unless already told to stop
+    /// \return false, since there is never anything more to do
+    bool step(const stop_token& token)
+    {
+        if(!token.stop_requested())
+        {
+            base_type::status(Status::Running);
+            base_type::service().run();
+        }
+
+        base_type::status(Status::Stopped);
+        return false;
+    }
+};
+
+
+/// What a Scheduler does once a periodic agent has fallen one or more whole intervals behind
+enum class CatchUp
+{
+    Burst,      ///< Run once per missed interval, back to back, until caught up
+    Skip,       ///< Don't run late, resume at the next aligned interval.  Never skips twice
+                ///< in a row, so one still running late by then runs anyway and realigns
+    Coalesce    ///< Run once right away covering all missed intervals, then resume aligned
+};
+
+
+template <class TDuration>
+class PeriodicBase
+{
+    const CatchUp catchUp_;
+
+public:
+    // relative time
+    typedef TDuration duration_type;
+
+    PeriodicBase(CatchUp catchUp = CatchUp::Burst) : catchUp_(catchUp) {}
+
+    CatchUp catchUp() const { return catchUp_; }
+
+    /// \param passed time elapsed since this agent's previous run
+    /// \return interval until next run, relative to when this run was due (not when it
+    /// actually happened) so that lateness does not accumulate.  duration_type::min()
+    /// requests removal
+    virtual duration_type run(duration_type passed) = 0;
+};
+
+
+/// Fixed-period intervals, and run indefinitely until system shuts them down
+/// \tparam TService
+template <class TService>
+class Periodic :
+        public PeriodicBase<typename TService::duration_type>,
+        public Base<TService>
+{
+    typedef Base<TService> base_type;
+    typedef typename TService::duration_type duration_type;
+    const duration_type interval;
+
+public:
+    Periodic(EnttHelper enttHelper, duration_type interval, CatchUp catchUp = CatchUp::Burst) :
+            PeriodicBase<duration_type>(catchUp),
+            base_type(enttHelper),
+            interval(interval) {}
+
+    duration_type run(duration_type passed) override
+    {
+        base_type::service().run(passed);
+        return interval;
+    }
+};
+
+/// Variable relative intervals, and can request self-shutdown
+/// \tparam TService
+template <class TService>
+class ScheduledRelative :
+        public PeriodicBase<typename TService::duration_type>,
+        public Base<TService>
+{
+    typedef Base<TService> base_type;
+    typedef typename TService::duration_type duration_type;
+
+public:
+    ScheduledRelative(EnttHelper entity, CatchUp catchUp = CatchUp::Burst) :
+            PeriodicBase<duration_type>(catchUp),
+            base_type(entity) {}
+
+    duration_type run(duration_type passed) override
+    {
+        return base_type::service().run(passed);
+    }
+};
+
+
+/// Optionally returned from a worker service's run(), saying when it next wants running
+/// @details Until then its worker parks, using no CPU, unless woken or stopped first
+class Idle
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+    typedef clock_type::time_point time_point;
+
+private:
+    time_point until_;
+
+    constexpr explicit Idle(time_point until) : until_(until) {}
+
+public:
+    /// Run again straight away
+    static constexpr Idle busy() { return Idle(time_point::min()); }
+
+    /// Park until wake() or stop
+    static constexpr Idle woken() { return Idle(time_point::max()); }
+
+    /// Park until 't', wake() or stop, whichever comes first
+    static constexpr Idle until(time_point t) { return Idle(t); }
+
+    /// Park for 'd', or until wake() or stop
+    template <class Rep, class Period>
+    static Idle after(std::chrono::duration<Rep, Period> d)
+    {
+        return Idle(clock_type::now() + std::chrono::duration_cast<clock_type::duration>(d));
+    }
+
+    constexpr time_point until() const { return until_; }
+    constexpr bool is_busy() const { return until_ == time_point::min(); }
+    constexpr bool forever() const { return until_ == time_point::max(); }
+};
+
+
+/// Run loop figures for a Worker
+struct WorkerStatistics
+{
+    typedef std::chrono::nanoseconds duration_type;
+
+    /// run() calls completed
+    std::uint64_t iterations = 0;
+    /// inside run()
+    duration_type busy {0};
+    /// parked between run() calls
+    duration_type idle {0};
+    /// thread CPU time within run loop, sampled every so often and whenever parking
+    duration_type cpu {0};
+
+    /// Share of accounted time spent inside run(), 0 through 1
+    double utilisation() const
+    {
+        duration_type total = busy + idle;
+
+        return total.count() == 0 ? 0 : double(busy.count()) / double(total.count());
+    }
+
+    /// Share of accounted time spent on CPU, 0 through 1.  Unlike utilisation(), a run()
+    /// blocked on I/O, a lock or a sleep doesn't count towards it
+    double cpuUtilisation() const
+    {
+        duration_type total = busy + idle;
+
+        // cpu is sampled, so may run a little ahead of busy and idle
+        return total.count() == 0 ? 0 : std::min(1.0, double(cpu.count()) / double(total.count()));
+    }
+
+    WorkerStatistics& operator+=(const WorkerStatistics& rhs)
+    {
+        iterations += rhs.iterations;
+        busy += rhs.busy;
+        idle += rhs.idle;
+        cpu += rhs.cpu;
+        return *this;
+    }
+};
+
+
+namespace internal {
+
+/// WorkerStatistics as kept by its one writer, and read by anyone without locking
+/// @details Each figure is individually coherent, though a reader may catch them mid update
+/// relative to one another.  Only the owning thread writes, so plain load/store suffices
+/// where an atomic read-modify-write would otherwise be needed
+class WorkerCounters
+{
+    typedef WorkerStatistics::duration_type duration_type;
+    typedef duration_type::rep rep;
+
+    std::atomic<std::uint64_t> iterations_ {0};
+    std::atomic<rep> busy_ {0};
+    std::atomic<rep> idle_ {0};
+    std::atomic<rep> cpu_ {0};
+    // CPU time at thread start, since a restarted service or reused thread may have
+    // clocked some up already.  Owning thread only
+    duration_type cpuBase {0};
+    duration_type cpuBefore {0};
+
+    template <class T>
+    static void add(std::atomic<T>& counter, T value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+public:
+    /// Owning thread only, as its run loop begins
+    void started()
+    {
+        cpuBase = moducom::services::internal::thread_cpu_time();
+        cpuBefore = duration_type(cpu_.load(std::memory_order_relaxed));
+    }
+
+    void ran(duration_type d)
+    {
+        add<std::uint64_t>(iterations_, 1);
+        add<rep>(busy_, d.count());
+    }
+
+    void parked(duration_type d)
+    {
+        add<rep>(idle_, d.count());
+    }
+
+    /// Owning thread only
+    void sample()
+    {
+        duration_type cpu = cpuBefore + moducom::services::internal::thread_cpu_time() - cpuBase;
+
+        cpu_.store(cpu.count(), std::memory_order_relaxed);
+    }
+
+    std::uint64_t iterations() const { return iterations_.load(std::memory_order_relaxed); }
+
+    WorkerStatistics statistics() const
+    {
+        WorkerStatistics s;
+
+        s.iterations = iterations_.load(std::memory_order_relaxed);
+        s.busy = duration_type(busy_.load(std::memory_order_relaxed));
+        s.idle = duration_type(idle_.load(std::memory_order_relaxed));
+        s.cpu = duration_type(cpu_.load(std::memory_order_relaxed));
+        return s;
+    }
+};
+
+}
+
+
+/// Told of a worker whose service run() threw, and decides what becomes of it
+class Supervisor
+{
+public:
+    typedef Idle::clock_type::duration duration_type;
+
+    /// Called on failed agent's own thread, its service already destructed
+    /// \return how long to hold off before restarting, or duration_type::max() to leave it down
+    virtual duration_type failed(Agent& agent, std::exception_ptr e) = 0;
+};
+
+
+namespace internal {
+
+inline std::string describe(std::exception_ptr e)
+{
+    try
+    {
+        std::rethrow_exception(e);
+    }
+    catch(const std::exception& ex)
+    {
+        return ex.what();
+    }
+    catch(...)
+    {
+        return "unknown exception";
+    }
+}
+
+/// Calls a service's run() over and over, parking when it says it's idle and tallying
+/// as it goes.  Shared by Worker and WorkerPool
+template <class TService>
+class RunLoop
+{
+    typedef Idle::clock_type clock_type;
+
+    static constexpr bool reports_idle =
+        std::is_same<decltype(std::declval<TService&>().run()), Idle>::value;
+
+    // Keeps thread CPU time sampling, a syscall, well clear of tight loops.  Power of 2
+    static constexpr std::uint64_t cpu_sample_interval = 64;
+    // ... while still sampling a slow run() often enough for WorkerPool to scale on
+    static constexpr std::chrono::milliseconds cpu_sample_period {10};
+
+    moducom::internal::Sleeper<clock_type> parker;
+    WorkerCounters counters_;
+    clock_type::time_point sampled;
+
+    void sample(clock_type::time_point now)
+    {
+        counters_.sample();
+        sampled = now;
+    }
+
+    /// Tallies a run() which began at 'mark'
+    /// \return when it finished
+    clock_type::time_point ran(clock_type::time_point mark)
+    {
+        clock_type::time_point now = clock_type::now();
+
+        counters_.ran(now - mark);
+
+        if((counters_.iterations() & (cpu_sample_interval - 1)) == 0 ||
+           now - sampled >= cpu_sample_period)
+            sample(now);
+
+        return now;
+    }
+
+    /// Parks as 'idle' says, tallying from 'mark'
+    /// \return when parking finished
+    clock_type::time_point park(const Idle& idle, clock_type::time_point mark)
+    {
+        if(idle.is_busy()) return mark;
+
+        sample(mark);
+        parker.sleep(!idle.forever(), idle.until());
+
+        clock_type::time_point now = clock_type::now();
+
+        counters_.parked(now - mark);
+        return now;
+    }
+
+public:
+    /// Calls service.run() until stop is requested or 'more' returns false.  Whatever
+    /// run() throws is passed along
+    /// \param more bool(), checked before each run()
+    template <class F>
+    void run(TService& service, const stop_token& stopToken, F&& more)
+    {
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        // Stop arriving before this is in place is caught by the loop condition, and any
+        // after is remembered by parker even if we're not yet parked
+        stop_callback stopCallback(stopToken, [this] { parker.wake(); });
+#else
+        // DEBT: Without stop_callback, an Idle::woken() service parks until wake()
+#endif
+
+        counters_.started();
+
+        try
+        {
+            clock_type::time_point mark = clock_type::now();
+
+            while(!stopToken.stop_requested() && more())
+            {
+                if constexpr (reports_idle)
+                {
+                    Idle idle = service.run();
+                    mark = park(idle, ran(mark));
+                }
+                else
+                {
+                    service.run();
+                    mark = ran(mark);
+                }
+            }
+        }
+        catch(...)
+        {
+            counters_.sample();
+            throw;
+        }
+
+        counters_.sample();
+    }
+
+    /// Holds off until 'until', or until stop is requested
+    /// \return false if stop was requested
+    bool holdoff(clock_type::time_point until, const stop_token& stopToken)
+    {
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        stop_callback stopCallback(stopToken, [this] { parker.wake(); });
+#else
+        // DEBT: Without stop_callback, stop isn't noticed until backoff is over
+#endif
+
+        while(!stopToken.stop_requested() && clock_type::now() < until)
+            parker.sleep(true, until);
+
+        return !stopToken.stop_requested();
+    }
+
+    /// Cuts short current or next park.  Thread safe
+    void wake() { parker.wake(); }
+
+    WorkerStatistics statistics() const { return counters_.statistics(); }
+};
+
+}
+
+
+/// Calls service run() over and over until stop is requested
+/// @details A run() returning void is called back to back, so it's on the service to pace
+/// itself.  One returning Idle instead parks in between for as long as it says.
+/// A run() which throws is handed to our Supervisor, if any, otherwise left in Status::Error
+template <class TService>
+class Worker : public Base<TService>
+{
+    typedef Base<TService> base_type;
+    typedef Idle::clock_type clock_type;
+
+    internal::RunLoop<TService> loop;
+    Supervisor* supervisor_ = nullptr;
+    std::atomic<bool> restarting {false};
+
+protected:
+    Worker(EnttHelper entity) : base_type(entity) {}
+
+    enum class Outcome
+    {
+        Stopped,        ///< stop requested, or gave up after failure
+        Restart         ///< construct service again and go around once more
+    };
+
+    /// Reports 'failure' and asks our Supervisor what next, holding off as it says.
+    /// Service is already destructed, or never got constructed
+    Outcome worker_failed(std::exception_ptr failure, const char* subsystem,
+                          const stop_token& stopToken)
+    {
+        base_type::error(internal::describe(failure), subsystem);
+
+        Supervisor::duration_type delay = supervisor_ != nullptr ?
+            supervisor_->failed(*this, failure) :
+            Supervisor::duration_type::max();
+
+        if(delay == Supervisor::duration_type::max())
+        {
+            // Terminal, so nothing may be reported after this
+            base_type::status(Status::Error);
+            return Outcome::Stopped;
+        }
+
+        if(!loop.holdoff(clock_type::now() + delay, stopToken))
+        {
+            base_type::status(Status::Stopped);
+            return Outcome::Stopped;
+        }
+
+        // Any restart requested meanwhile is satisfied by this one
+        restarting = false;
+        base_type::status(Status::Starting);
+        return Outcome::Restart;
+    }
+
+    /// Constructs service with 'construct', then carries on as worker_after_construction().
+    /// A constructor which throws fails just as run() throwing does
+    template <class F>
+    Outcome worker_construct(F&& construct, const stop_token& stopToken)
+    {
+        try
+        {
+            construct();
+        }
+        catch(...)
+        {
+            return worker_failed(std::current_exception(), "construct", stopToken);
+        }
+
+        return worker_after_construction(stopToken);
+    }
+
+    /// Runs service until stop or restart is requested, or it throws.  Either way service is
+    /// destructed on the way out
+    Outcome worker_after_construction(const stop_token& stopToken)
+    {
+        std::exception_ptr failure;
+
+        base_type::status(Status::Started);
+        base_type::status(Status::Running);
+
+        try
+        {
+            loop.run(base_type::service(), stopToken, [this] { return !restarting; });
+        }
+        catch(...)
+        {
+            failure = std::current_exception();
+        }
+
+        if(failure)
+        {
+            // Whatever state service was left in, it's not to be trusted
+            base_type::destruct();
+            return worker_failed(failure, "run", stopToken);
+        }
+
+        if(restarting.exchange(false) && !stopToken.stop_requested())
+        {
+            base_type::destruct();
+            base_type::status(Status::Starting);
+            return Outcome::Restart;
+        }
+
+        base_type::status(Status::Stopping);
+        base_type::destruct();
+
+        // DEBT: Would be better if this was set when thread itself terminated
+        base_type::status(Status::Stopped);
+        return Outcome::Stopped;
+    }
+
+public:
+    /// Cuts short a parked service's idle period, so its run() is called promptly.
+    /// A wake arriving while not parked skips the next park instead.  Thread safe
+    void wake()
+    {
+        base_type::arrived();
+        loop.wake();
+    }
+
+    /// Run loop figures so far, across restarts.  Lock free, and callable from any thread
+    WorkerStatistics statistics() const { return loop.statistics(); }
+
+    /// Who decides whether a service which threw comes back.  Set before run()
+    void supervisor(Supervisor* s) { supervisor_ = s; }
+
+    /// Tears down service and constructs it afresh on the same thread, once its current
+    /// run() returns.  Thread safe
+    void restart()
+    {
+        restarting = true;
+        loop.wake();
+    }
+};
+
+
+// NOTE: Not a fan of holding on to initiatization arguments forever.  So this is
+// a tracer code style approach for now
+template <class TService, class ...TArgs>
+class StandaloneStdThread : public Worker<TService>
+{
+    typedef Worker<TService> base_type;
+    typedef StandaloneStdThread this_type;
+
+    // holding on to ctor args here
+    // guidance from https://stackoverflow.com/questions/15537817/c-how-to-store-a-parameter-pack-as-a-variable
+    std::tuple<TArgs...> ctor_args;
+
+public:
+    static constexpr bool threaded = true;
+
+    StandaloneStdThread(EnttHelper entity, TArgs&&... args) :
+            base_type(entity),
+            ctor_args(std::forward<TArgs>(args)...)
+    {
+
+    }
+
+    void construct()
+    {
+        std::apply([&](const TArgs&... args)
+                   {
+                       base_type::construct(args...);
+                   }, ctor_args);
+    }
+
+    void worker(
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+            stop_token token,
+#else
+            const stop_token& token,
+#endif
+            ThreadAttributes attributes)
+    {
+        base_type::applyThreadAttributes(attributes);
+
+        // Storage lives inside this agent, whose pages were likely first touched by whoever
+        // created it.  Pull them over before construction touches them again.
+        // NOTE: Takes whatever else shares those pages along too
+        if(attributes.node >= 0)
+            moducom::internal::numa::move(&base_type::service(), sizeof(TService), attributes.node);
+
+        // DEBT: Would prefer the pass-function-as-template-parameter flavor and
+        // completely consolidate construct() call down into Worker class.  Proved to
+        // be kinda tricky, so not doing so just yet
+        // Restarts come back around here, into the same storage on the same thread
+        while(base_type::worker_construct([this] { construct(); }, token) ==
+              base_type::Outcome::Restart);
+    }
+
+    std::thread run(const stop_token& token)
+    {
+        base_type::status(Status::Starting);
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        // By value, since 'token' is often a temporary gone before the thread gets to it
+        std::thread thread(&this_type::worker, this, token, base_type::threadAttributes());
+#else
+        std::thread thread(&this_type::worker, this, std::ref(token), base_type::threadAttributes());
+#endif
+        return thread;
+    }
+};
+
+template <class TService, class ...TArgs>
+auto make_standalone(EnttHelper enttHelper, TArgs&&... args)
+{
+    // Returned in place, since its parker can be neither copied nor moved
+    return StandaloneStdThread<TService, TArgs...>(
+            enttHelper,
+            std::forward<TArgs>(args)...);
+}
+
+
+/// When and how far a WorkerPool grows and shrinks
+struct PoolPolicy
+{
+    unsigned minimum = 1;
+    unsigned maximum = std::max(1U, std::thread::hardware_concurrency());
+    /// How often utilisation and backlog are looked at
+    std::chrono::milliseconds interval {100};
+    /// Share of time members spent on CPU since last look, above which one is added...
+    double scaleUp = 0.8;
+    /// ... and below which one is retired
+    double scaleDown = 0.2;
+    /// Service backlog() per member above which one is added, regardless of utilisation
+    std::size_t backlogPerMember = 1;
+};
+
+/// One change in WorkerPool size, and what prompted it
+struct ScalingDecision
+{
+    unsigned from;
+    unsigned to;
+    /// share of time on CPU, as measured over the interval leading up to this decision
+    double utilisation;
+    std::size_t backlog;
+};
+
+
+/// Runs service run() loops on several threads at once, growing and shrinking their number
+/// with demand
+/// @details A service whose reentrant() is true is constructed once and shared by every
+/// member thread, otherwise each member constructs its own from the same arguments.  A
+/// controller thread looks every PoolPolicy::interval at how busy members were and, for a
+/// shared service only, its backlog() if it has one.  It then adds or retires at most one
+/// member.  Busy means on CPU, so members blocked inside run() don't grow the pool.  A member
+/// whose service constructor or run() throws is reported through error() and retired, and
+/// replaced if that takes the pool below its minimum.  A shared service whose constructor
+/// throws leaves the pool in Status::Error with no members
+template <class TService, class ...TArgs>
+class WorkerPool : public Base<TService>
+{
+    typedef Base<TService> base_type;
+    typedef WorkerPool this_type;
+    typedef Idle::clock_type clock_type;
+
+    static constexpr bool shared = TService::reentrant();
+
+    struct Member
+    {
+        unsigned index;
+        internal::RunLoop<TService> loop;
+        // Not used when shared
+        Container<TService> own;
+        std::atomic<bool> retiring {false};
+        std::atomic<bool> exited {false};
+        std::thread thread;
+        // As of controller's last look.  Controller only
+        WorkerStatistics seen;
+    };
+
+    entt::sigh<void(Agent*, ScalingDecision)> scalingSignal_;
+
+    // holding on to ctor args here, as StandaloneStdThread does
+    std::tuple<TArgs...> ctor_args;
+    const PoolPolicy policy_;
+
+    moducom::internal::Sleeper<clock_type> controller;
+    // Guards 'members' and 'retired' against statistics().  Only controller changes them
+    std::mutex mutex;
+    // std::list, since member threads each hold on to theirs
+    std::list<Member> members;
+    // Figures from members since reaped
+    WorkerStatistics retired;
+    std::atomic<unsigned> size_ {0};
+    unsigned nextIndex = 0;
+
+    TService& instance(Member& m)
+    {
+        if constexpr (shared)
+            return base_type::service();
+        else
+            return m.own.contained();
+    }
+
+    void member(Member& m, const stop_token& token, ThreadAttributes attributes)
+    {
+        base_type::applyThreadAttributes(attributes);
+
+        if constexpr (!shared)
+        {
+            try
+            {
+                std::apply([&](const TArgs&... args) { m.own.construct(args...); }, ctor_args);
+            }
+            catch(...)
+            {
+                // Retired as though run() threw, without ever running
+                base_type::error(internal::describe(std::current_exception()), "construct");
+                m.exited = true;
+                controller.wake();
+                return;
+            }
+        }
+
+        try
+        {
+            m.loop.run(instance(m), token, [&m] { return !m.retiring; });
+        }
+        catch(...)
+        {
+            base_type::error(internal::describe(std::current_exception()), "run");
+        }
+
+        if constexpr (!shared) m.own.destruct();
+
+        m.exited = true;
+        controller.wake();
+    }
+
+    void add(const stop_token& token, const ThreadAttributes& attributes)
+    {
+        ThreadAttributes a = attributes;
+        unsigned index = nextIndex++;
+
+        if(!a.name.empty()) a.name += "/" + std::to_string(index);
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        members.emplace_back();
+        Member& m = members.back();
+        m.index = index;
+        // Each member sees the same stop token, so stop needs nothing further from us
+        m.thread = std::thread([this, &m, token, a] { member(m, token, a); });
+        ++size_;
+    }
+
+    /// Joins members which have exited, whether retired or failed
+    void reap()
+    {
+        std::vector<std::thread> exited;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for(auto i = members.begin(); i != members.end();)
+            {
+                if(!i->exited)
+                {
+                    ++i;
+                    continue;
+                }
+
+                // Retired members were already taken off size_ when asked to go
+                if(!i->retiring) --size_;
+
+                retired += i->loop.statistics();
+                exited.push_back(std::move(i->thread));
+                i = members.erase(i);
+            }
+        }
+
+        for(std::thread& t : exited) t.join();
+    }
+
+    void evaluate(const stop_token& token, const ThreadAttributes& attributes)
+    {
+        reap();
+
+        WorkerStatistics delta;
+        Member* newest = nullptr;
+
+        for(Member& m : members)
+        {
+            if(m.retiring) continue;
+
+            WorkerStatistics now = m.loop.statistics();
 
-protected:
-    typedef service_type& reference;
+            delta.busy += now.busy - m.seen.busy;
+            delta.idle += now.idle - m.seen.idle;
+            delta.cpu += now.cpu - m.seen.cpu;
+            m.seen = now;
+            newest = &m;
+        }
 
-public:
-    Base(EnttHelper entity) : Agent(entity) {}
+        ScalingDecision d;
 
-    reference service()
-    {
-        return container_base::contained();
-    }
+        d.from = size_;
+        d.to = d.from;
+        d.utilisation = delta.cpuUtilisation();
+        d.backlog = 0;
 
-    static Description description()
-    {
-        return service_type::description();
+        if constexpr (shared)
+            d.backlog = internal::backlog(base_type::service(), 0);
+
+        if(d.from < policy_.minimum)
+            d.to = policy_.minimum;
+        else if(d.from < policy_.maximum &&
+                (d.utilisation > policy_.scaleUp || d.backlog > d.from * policy_.backlogPerMember))
+            ++d.to;
+        else if(d.from > policy_.minimum && d.utilisation < policy_.scaleDown && d.backlog == 0)
+            --d.to;
+
+        if(d.to == d.from) return;
+
+        for(unsigned n = d.from; n < d.to; ++n) add(token, attributes);
+
+        if(d.to < d.from)
+        {
+            newest->retiring = true;
+            newest->loop.wake();
+            --size_;
+        }
+
+        scalingSignal_.publish(this, d);
     }
 
-    template <class ... TArgs>
-    void construct(TArgs&&...args)
+    void worker(
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+            stop_token token,
+#else
+            const stop_token& token,
+#endif
+            ThreadAttributes attributes)
     {
-        Agent::status(Status::Starting);
-        container_base::construct(std::forward<TArgs>(args)...);
-        Agent::status(Status::Started);
-    }
-};
+        base_type::applyThreadAttributes(attributes);
 
-template <class TService, ServiceBase::ThreadPreference>
-class SingleShot;
+        if constexpr (shared)
+        {
+            try
+            {
+                std::apply([&](const TArgs&... args) { base_type::construct(args...); }, ctor_args);
+            }
+            catch(...)
+            {
+                base_type::error(internal::describe(std::current_exception()), "construct");
+                // Terminal, so nothing may be reported after this
+                base_type::status(Status::Error);
+                return;
+            }
+        }
 
-template <class TService>
-class SingleShot<TService,
-        ServiceBase::ThreadPreference::PreferThreaded> : public Base<TService>
-{
-    typedef Base<TService> base_type;
+        base_type::status(Status::Started);
+        base_type::status(Status::Running);
 
-public:
-};
+        {
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+            stop_callback stopCallback(token, [this] { controller.wake(); });
+#else
+            // DEBT: Without stop_callback, stop isn't noticed until next interval
+#endif
+            clock_type::time_point next = clock_type::now();
 
+            while(!token.stop_requested())
+            {
+                if(clock_type::now() >= next)
+                {
+                    evaluate(token, attributes);
+                    next = clock_type::now() + policy_.interval;
+                }
+                else
+                    // woken by a member exiting
+                    reap();
 
-template <class TDuration>
-class PeriodicBase
-{
-public:
-    // relative time
-    typedef TDuration duration_type;
+                controller.sleep(true, next);
+            }
+        }
 
-    virtual duration_type run(duration_type passed) = 0;
-};
+        base_type::status(Status::Stopping);
 
+        // Members share our stop token, so are on their way out already
+        for(Member& m : members) m.thread.join();
 
-/// Fixed-period intervals, and run indefinitely until system shuts them down
-/// \tparam TService
-template <class TService>
-class Periodic :
-        public PeriodicBase<typename TService::duration_type>,
-        public Base<TService>
-{
-    typedef Base<TService> base_type;
-    typedef typename TService::duration_type duration_type;
-    const duration_type interval;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
 
-public:
-    Periodic(EnttHelper enttHelper, duration_type interval) :
-            base_type(enttHelper),
-            interval(interval) {}
+            for(Member& m : members) retired += m.loop.statistics();
+            members.clear();
+        }
 
-    duration_type run(duration_type passed) override
-    {
-        base_type::service().run(passed);
-        return interval;
-    }
-};
+        size_ = 0;
 
-/// Variable relative intervals, and can request self-shutdown
-/// \tparam TService
-template <class TService>
-class ScheduledRelative :
-        public PeriodicBase<typename TService::duration_type>,
-        public Base<TService>
-{
-    typedef Base<TService> base_type;
-    typedef typename TService::duration_type duration_type;
+        if constexpr (shared) base_type::destruct();
+
+        base_type::status(Status::Stopped);
+    }
 
 public:
-    ScheduledRelative(EnttHelper entity) : base_type(entity) {}
+    static constexpr bool threaded = true;
 
-    duration_type run(duration_type passed) override
-    {
-        return base_type::service().run(passed);
-    }
-};
+    entt::sink<void(Agent*, ScalingDecision)> scalingSink;
 
+    WorkerPool(EnttHelper entity, const PoolPolicy& policy, TArgs&&... args) :
+        base_type(entity),
+        ctor_args(std::forward<TArgs>(args)...),
+        policy_(policy),
+        scalingSink{scalingSignal_}
+    {}
 
-template <class TService>
-class Worker : public Base<TService>
-{
-    typedef Base<TService> base_type;
+    /// Members currently running, not counting any on their way out
+    unsigned size() const { return size_; }
 
-protected:
-    Worker(EnttHelper entity) : base_type(entity) {}
+    const PoolPolicy& policy() const { return policy_; }
 
-protected:
+    /// Run loop figures summed across all members, past and present.  Thread safe
+    WorkerStatistics statistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        WorkerStatistics s = retired;
+
+        for(Member& m : members) s += m.loop.statistics();
 
-    void worker_after_construction(const stop_token& stopToken)
+        return s;
+    }
+
+    /// Cuts short every member's idle period.  Thread safe
+    void wake()
     {
-        base_type::status(Status::Started);
-        base_type::status(Status::Running);
+        base_type::arrived();
 
-        while(!stopToken.stop_requested())
-        {
-            base_type::service().run();
-        }
+        std::lock_guard<std::mutex> lock(mutex);
 
-        base_type::status(Status::Stopping);
-        base_type::destruct();
+        for(Member& m : members) m.loop.wake();
+    }
 
-        // DEBT: Would be better if this was set when thread itself terminated
-        base_type::status(Status::Stopped);
+    std::thread run(const stop_token& token)
+    {
+        base_type::status(Status::Starting);
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        return std::thread(&this_type::worker, this, token, base_type::threadAttributes());
+#else
+        return std::thread(&this_type::worker, this, std::ref(token), base_type::threadAttributes());
+#endif
     }
 };
 
+template <class TService, class ...TArgs>
+auto make_worker_pool(EnttHelper enttHelper, const PoolPolicy& policy, TArgs&&... args)
+{
+    return WorkerPool<TService, TArgs...>(enttHelper, policy, std::forward<TArgs>(args)...);
+}
+
 
-// NOTE: Not a fan of holding on to initiatization arguments forever.  So this is
-// a tracer code style approach for now
+/// Worker which shares a thread, one run() per step
+/// @details Service is constructed on first step and destructed on the first step after
+/// stop is requested, both on the executor's thread.  Be sure service run() returns
+/// promptly, since everyone else on that thread waits on it
 template <class TService, class ...TArgs>
-class StandaloneStdThread : public Worker<TService>
+class CooperativeWorker : public Base<TService>
 {
-    typedef Worker<TService> base_type;
-    typedef StandaloneStdThread this_type;
+    typedef Base<TService> base_type;
+
+    static constexpr bool reports_idle =
+        std::is_same<decltype(std::declval<TService&>().run()), Idle>::value;
 
-    // holding on to ctor args here
-    // guidance from https://stackoverflow.com/questions/15537817/c-how-to-store-a-parameter-pack-as-a-variable
     std::tuple<TArgs...> ctor_args;
+    bool constructed = false;
+
+    // As last returned by run().  Busy until it first runs
+    Idle idle_ = Idle::busy();
+    std::atomic<bool> woken_ {false};
+    std::function<void ()> waker_;
 
 public:
-    StandaloneStdThread(EnttHelper entity, TArgs&&... args) :
+    static constexpr bool threaded = false;
+
+    CooperativeWorker(EnttHelper entity, TArgs&&... args) :
             base_type(entity),
             ctor_args(std::forward<TArgs>(args)...)
     {
 
     }
 
-    void construct()
+    /// \return false once stopped, after which this worker needs no more steps
+    bool step(const stop_token& token)
     {
-        std::apply([&](const TArgs&... args)
-                   {
-                       base_type::construct(args...);
-                   }, ctor_args);
+        if(token.stop_requested())
+        {
+            base_type::status(Status::Stopping);
+            if(constructed) base_type::destruct();
+            constructed = false;
+            base_type::status(Status::Stopped);
+            return false;
+        }
+
+        if(!constructed)
+        {
+            std::apply([&](const TArgs&... args)
+                       {
+                           base_type::construct(args...);
+                       }, ctor_args);
+            constructed = true;
+            base_type::status(Status::Running);
+        }
+
+        // Cleared beforehand, so that a wake() arriving mid run() isn't lost
+        woken_ = false;
+
+        if constexpr (reports_idle)
+            idle_ = base_type::service().run();
+        else
+            base_type::service().run();
+
+        return true;
     }
 
-    void worker(
-#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-            stop_token token
-#else
-            const stop_token& token
-#endif
-            )
+    /// When this worker next wants a step, per the Idle its service's run() last returned.
+    /// Services whose run() returns void always want one
+    Idle::time_point due() const
     {
-        // DEBT: Would prefer the pass-function-as-template-parameter flavor and
-        // completely consolidate construct() call down into Worker class.  Proved to
-        // be kinda tricky, so not doing so just yet
-        construct();
-        base_type::worker_after_construction(token);
+        return woken_ ? Idle::time_point::min() : idle_.until();
     }
 
-    std::thread run(const stop_token& token)
+    /// Cuts short current idle.  Thread safe
+    void wake()
     {
-        base_type::status(Status::Starting);
-        std::thread thread(&this_type::worker, this, std::ref(token));
-        return thread;
+        woken_ = true;
+        if(waker_) waker_();
     }
+
+    /// Called by wake(), so that whoever steps us takes notice.  Set before placing
+    void waker(std::function<void ()> f) { waker_ = std::move(f); }
 };
 
+
+/// Picks StandaloneStdThread or CooperativeWorker per TService::threadPreference()
 template <class TService, class ...TArgs>
-auto make_standalone(EnttHelper enttHelper, TArgs&&... args)
-{
-    StandaloneStdThread<TService, TArgs...> agent(
-            enttHelper,
-            std::forward<TArgs>(args)...);
-    return agent;
-}
+using worker_t = std::conditional_t<needs_thread<TService>(),
+    StandaloneStdThread<TService, TArgs...>,
+    CooperativeWorker<TService, TArgs...> >;
 
 
 // non-async external event responder.  Be sure to handle things quickly!
@@ -493,18 +1879,24 @@ public:
 
 namespace internal {
 
-template <class T>
+template <class T, class TContainer = std::deque<T> >
 class BlockingQueue
 {
     typedef T value_type;
     typedef value_type& reference;
-    std::queue<T> queue;
+    typedef std::queue<T, TContainer> queue_type;
+    queue_type queue;
 
     std::condition_variable cv;
     std::mutex cv_m;
 
 public:
-    std::queue<T>& q() { return queue; }
+    BlockingQueue() = default;
+
+    /// \param container starts out as backing store, typically empty but with a custom allocator
+    explicit BlockingQueue(const TContainer& container) : queue(container) {}
+
+    queue_type& q() { return queue; }
 
     std::unique_lock<std::mutex> unique_lock()
     {
@@ -589,7 +1981,11 @@ class AsyncEventQueue : public Base<TService>
     typedef typename message_factory_type::message_type message_type;
     typedef typename message_factory_type::event_args event_args;
 
-    internal::BlockingQueue<message_type> queue;
+    typedef moducom::internal::numa::Allocator<message_type> allocator_type;
+    typedef std::deque<message_type, allocator_type> container_type;
+
+    // On the node our worker will run on, if any
+    internal::BlockingQueue<message_type, container_type> queue;
 
     // DEBT: I think we can do this with just the future variable
     bool workerRunning = false;
@@ -613,15 +2009,18 @@ class AsyncEventQueue : public Base<TService>
     /// condition
     void worker(
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-            stop_token stopToken
+            stop_token stopToken,
 #else
-            const stop_token& stopToken
+            const stop_token& stopToken,
 #endif
-            )
+            ThreadAttributes attributes)
     {
         using namespace std::chrono_literals;
         int counter = 10;
 
+        // std::async may hand us a fresh thread each burst, so this is applied every time
+        base_type::applyThreadAttributes(attributes);
+
         // Worker is always started with at least one entry in the queue, so we
         // use a do/while
 
@@ -664,7 +2063,12 @@ class AsyncEventQueue : public Base<TService>
     std::future<void> workerFuture;
 
 public:
-    AsyncEventQueue(EnttHelper eh) : base_type(eh) {}
+    /// Queue memory is placed per thread attributes already configured for 'eh', or
+    /// otherwise as TService declares
+    AsyncEventQueue(EnttHelper eh) :
+        base_type(eh),
+        queue(container_type(allocator_type(base_type::threadAttributes().node)))
+    {}
     ~AsyncEventQueue()
     {
         stop();
@@ -700,6 +2104,7 @@ public:
     template <class ...TArgs>
     void run(TArgs&&...args)
     {
+        base_type::arrived();
         queue.emplace(false, event_args(std::forward<TArgs>(args)...));
 
         {
@@ -716,13 +2121,177 @@ public:
             // future destructor will block, if necessary while worker finishes up
             workerFuture = std::async(std::launch::async, &AsyncEventQueue::worker, this,
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-                                      stopSource.token()
+                                      stopSource.token(),
 #else
-                                      std::ref(stopSource.token())
+                                      std::ref(stopSource.token()),
 #endif
-                                      );
+                                      base_type::threadAttributes());
+        }
+    }
+};
+
+namespace internal {
+
+/// Unique for the life of the process, unlike an address
+inline std::uint64_t next_serial()
+{
+    static std::atomic<std::uint64_t> serial {0};
+    return ++serial;
+}
+
+/// Calling thread's mailbox in each Mailboxes it has pushed to, by serial
+/// DEBT: Entries for Mailboxes long gone linger until thread exit
+inline std::unordered_map<std::uint64_t, void*>& mailbox_cache()
+{
+    thread_local std::unordered_map<std::uint64_t, void*> cache;
+    return cache;
+}
+
+/// One SPSC queue per producer thread, all drained by a single consumer
+/// @details A thread's first push registers its mailbox on a lock free list which the
+/// consumer walks.  Order holds per producer, not across them
+template <class T>
+class Mailboxes
+{
+    struct Mailbox
+    {
+        moducom::internal::SpscQueue<T> queue;
+        Mailbox* next = nullptr;
+    };
+
+    const std::uint64_t serial = next_serial();
+    std::atomic<Mailbox*> head {nullptr};
+
+    Mailbox& mine()
+    {
+        void*& cached = mailbox_cache()[serial];
+
+        if(cached == nullptr)
+        {
+            auto m = new Mailbox;
+
+            m->next = head.load(std::memory_order_relaxed);
+            while(!head.compare_exchange_weak(m->next, m,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+            cached = m;
+        }
+
+        return *static_cast<Mailbox*>(cached);
+    }
+
+public:
+    Mailboxes() = default;
+    Mailboxes(const Mailboxes&) = delete;
+
+    ~Mailboxes()
+    {
+        for(Mailbox* m = head.load(); m != nullptr;)
+        {
+            Mailbox* next = m->next;
+            delete m;
+            m = next;
+        }
+    }
+
+    /// From any thread
+    template <class ...TArgs>
+    void emplace(TArgs&&...args)
+    {
+        mine().queue.emplace(std::forward<TArgs>(args)...);
+    }
+
+    /// Consumer only.  Hands 'f' everything waiting, mailbox by mailbox
+    /// \return how many were handed over
+    template <class F>
+    std::size_t drain(F&& f)
+    {
+        std::size_t n = 0;
+
+        for(Mailbox* m = head.load(std::memory_order_acquire); m != nullptr; m = m->next)
+            while(m->queue.consume(f)) ++n;
+
+        return n;
+    }
+
+    /// Threads which have pushed so far
+    std::size_t size() const
+    {
+        std::size_t n = 0;
+
+        for(Mailbox* m = head.load(std::memory_order_acquire); m != nullptr; m = m->next) ++n;
+
+        return n;
+    }
+};
+
+}
+
+/// Event agent whose service only ever runs on its owner's thread
+/// @details Events raised on the owner's thread run right away, as with Event.  Those raised
+/// anywhere else, such as a libusb callback thread, land in that thread's own mailbox for the
+/// owner to drain.  So delivery takes no shared lock and handlers never hold up the raising
+/// thread.  Owner is nudged with one post() per burst rather than per event.  Be sure
+/// producers are done and owner has drained (or stopped) before this goes away
+/// \tparam TOwner CooperativeExecutor, Reactor or anything else exposing post(task) and
+/// threadId()
+template <class TService, class TOwner>
+class OwnedEvent : public Event<TService>
+{
+    typedef Event<TService> base_type;
+    typedef typename internal::QueuedMessageFactory<TService>::event_args event_args;
+
+    TOwner& owner_;
+    internal::Mailboxes<event_args> mailboxes;
+    // Drain is posted and has yet to begin
+    std::atomic<bool> scheduled {false};
+
+    // Spelled out rather than std::apply, whose generic lambda trips up gcc here
+    template <std::size_t ...Is>
+    void deliver(event_args& args, std::index_sequence<Is...>)
+    {
+        base_type::run(std::get<Is>(args)...);
+    }
+
+public:
+    OwnedEvent(EnttHelper eh, TOwner& owner) :
+        base_type(eh),
+        owner_(owner)
+    {}
+
+    TOwner& owner() const { return owner_; }
+
+    template <class ...TArgs>
+    void run(TArgs&&...args)
+    {
+        if(std::this_thread::get_id() == owner_.threadId())
+        {
+            base_type::run(std::forward<TArgs>(args)...);
+            return;
         }
+
+        mailboxes.emplace(std::forward<TArgs>(args)...);
+        Agent::arrived();
+
+        // Both sides exchange, so either drain sees this event or we post another
+        if(!scheduled.exchange(true, std::memory_order_acq_rel))
+            owner_.post([this] { drain(); });
+    }
+
+    /// Runs everything waiting in mailboxes.  Owner thread only
+    /// \return how many events ran
+    std::size_t drain()
+    {
+        scheduled.exchange(false, std::memory_order_acq_rel);
+
+        return mailboxes.drain([this](event_args& args)
+        {
+            deliver(args, std::make_index_sequence<std::tuple_size<event_args>::value>());
+        });
     }
+
+    /// Threads which have raised events from afar so far
+    std::size_t producers() const { return mailboxes.size(); }
 };
 
 }}}
@@ -0,0 +1,35 @@
+/**
+ * @file
+ * @brief Bit scanning helpers
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace moducom { namespace internal { namespace bits {
+
+/// index of lowest set bit.  Undefined for 0
+inline unsigned ctz(std::uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    unsigned n = 0;
+    while(!(v & 1)) { v >>= 1; ++n; }
+    return n;
+#endif
+}
+
+/// index of highest set bit.  Undefined for 0
+inline unsigned msb(std::uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    unsigned n = 0;
+    while(v >>= 1) ++n;
+    return n;
+#endif
+}
+
+}}}
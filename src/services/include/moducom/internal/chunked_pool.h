@@ -0,0 +1,134 @@
+/**
+ * @file
+ * @brief Contiguous, address-stable object storage
+ * @details Objects live by value in fixed-size chunks, so neighbors of the same type sit next to
+ *          each other in memory while never moving once constructed.  That last part matters
+ *          since agents hand out pointers to themselves (sinks, Depender, schedulers) and so
+ *          cannot live in a relocating container such as an entt component pool
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace moducom { namespace internal {
+
+template <class T, std::size_t ChunkSize = 256>
+class ChunkedPool
+{
+public:
+    typedef T value_type;
+    typedef value_type& reference;
+    typedef std::size_t size_type;
+
+    static constexpr size_type chunk_size = ChunkSize;
+
+private:
+    typedef std::aligned_storage_t<sizeof(T), alignof(T)> storage_type;
+
+    std::vector<std::unique_ptr<storage_type[]> > chunks;
+    std::vector<bool> live;
+    // recycled slots, LIFO so that recently freed (and likely still cached) memory is reused first
+    std::vector<size_type> free_;
+    size_type size_ = 0;
+
+    storage_type& raw(size_type slot)
+    {
+        return chunks[slot / chunk_size][slot % chunk_size];
+    }
+
+    size_type acquire()
+    {
+        if(!free_.empty())
+        {
+            size_type slot = free_.back();
+            free_.pop_back();
+            return slot;
+        }
+
+        size_type slot = live.size();
+
+        if(slot == capacity())
+            chunks.emplace_back(new storage_type[chunk_size]);
+
+        live.push_back(false);
+        return slot;
+    }
+
+public:
+    ChunkedPool() = default;
+    ChunkedPool(const ChunkedPool&) = delete;
+    ChunkedPool& operator=(const ChunkedPool&) = delete;
+
+    ~ChunkedPool()
+    {
+        for(size_type slot = 0; slot < live.size(); ++slot)
+            if(live[slot]) erase(slot);
+    }
+
+    size_type size() const { return size_; }
+    size_type capacity() const { return chunks.size() * chunk_size; }
+
+    /// Allocates (but does not construct) enough chunks to hold 'n' objects in total
+    void reserve(size_type n)
+    {
+        while(capacity() < n)
+            chunks.emplace_back(new storage_type[chunk_size]);
+
+        live.reserve(n);
+    }
+
+    bool contains(size_type slot) const
+    {
+        return slot < live.size() && live[slot];
+    }
+
+    /// Constructs a new T in place
+    /// \return slot index of new T, stable until erased
+    template <class ...TArgs>
+    size_type emplace(TArgs&&...args)
+    {
+        size_type slot = acquire();
+
+        try
+        {
+            ::new ((void*) std::addressof(raw(slot))) value_type(std::forward<TArgs>(args)...);
+        }
+        catch(...)
+        {
+            free_.push_back(slot);
+            throw;
+        }
+
+        live[slot] = true;
+        ++size_;
+        return slot;
+    }
+
+    void erase(size_type slot)
+    {
+        (*this)[slot].~value_type();
+        live[slot] = false;
+        free_.push_back(slot);
+        --size_;
+    }
+
+    reference operator[](size_type slot)
+    {
+        return reinterpret_cast<reference>(raw(slot));
+    }
+
+    /// Visits each live object in storage order, i.e. sequentially through memory
+    template <class F>
+    void each(F&& f)
+    {
+        for(size_type slot = 0; slot < live.size(); ++slot)
+            if(live[slot]) f(slot, (*this)[slot]);
+    }
+};
+
+}}
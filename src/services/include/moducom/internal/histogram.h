@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @brief Fixed size, power-of-two bucketed histogram
+ * @details Recording is a bit scan and an increment, with no allocation, so it is cheap
+ *          enough to leave on in production.  Precision is within a factor of two, which is
+ *          plenty to tell jitter apart from a stall
+ */
+#pragma once
+
+#include "bits.h"
+
+#include <array>
+#include <cstdint>
+
+namespace moducom { namespace internal {
+
+/// Bucket 0 counts zeroes, bucket n counts [2^(n-1), 2^n) and the last bucket also
+/// counts everything beyond it
+template <unsigned Buckets = 32>
+class Log2Histogram
+{
+public:
+    typedef std::uint64_t value_type;
+    typedef std::uint32_t count_type;
+
+    static constexpr unsigned buckets = Buckets;
+
+private:
+    std::array<count_type, buckets> counts {};
+
+public:
+    static unsigned bucket(value_type v)
+    {
+        if(v == 0) return 0;
+
+        unsigned b = bits::msb(v) + 1;
+        return b < buckets ? b : buckets - 1;
+    }
+
+    /// smallest value which lands in bucket 'b'
+    static value_type lower(unsigned b)
+    {
+        return b == 0 ? 0 : value_type(1) << (b - 1);
+    }
+
+    /// largest value which lands in bucket 'b', saturating for the last one
+    static value_type upper(unsigned b)
+    {
+        if(b == 0) return 0;
+        if(b == buckets - 1) return ~value_type(0);
+        return (value_type(1) << b) - 1;
+    }
+
+    void add(value_type v)
+    {
+        ++counts[bucket(v)];
+    }
+
+    count_type operator[](unsigned b) const { return counts[b]; }
+
+    value_type count() const
+    {
+        value_type total = 0;
+        for(count_type c : counts) total += c;
+        return total;
+    }
+
+    /// \param q quantile 0.0 - 1.0
+    /// \return upper bound of bucket holding the 'q' quantile, or 0 when empty
+    value_type quantile(double q) const
+    {
+        value_type total = count();
+
+        if(total == 0) return 0;
+
+        value_type target = static_cast<value_type>(q * total);
+        if(target >= total) target = total - 1;
+
+        value_type seen = 0;
+
+        for(unsigned b = 0; b < buckets; ++b)
+        {
+            seen += counts[b];
+            if(seen > target) return upper(b);
+        }
+
+        return upper(buckets - 1);
+    }
+
+    Log2Histogram& operator+=(const Log2Histogram& rhs)
+    {
+        for(unsigned b = 0; b < buckets; ++b) counts[b] += rhs.counts[b];
+        return *this;
+    }
+
+    void clear() { counts.fill(0); }
+};
+
+}}
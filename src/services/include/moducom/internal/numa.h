@@ -0,0 +1,373 @@
+/**
+ * @file
+ * @brief NUMA topology, memory placement and a node-local allocator
+ * @details Straight syscalls and sysfs rather than libnuma, so there's nothing extra to link.
+ *          Linux only.  Elsewhere everything reports a single node 0 of unknown CPUs, and
+ *          allocation falls back to the free store
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#if __linux__
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace moducom { namespace internal { namespace numa {
+
+#if __linux__
+namespace sys {
+
+// From linux/mempolicy.h, which isn't always installed
+constexpr int mpol_preferred = 1;
+constexpr unsigned mpol_mf_move = 1 << 1;
+constexpr unsigned long mpol_f_node = 1 << 0;
+constexpr unsigned long mpol_f_addr = 1 << 1;
+
+// Comfortably more nodes than any machine we'll meet
+constexpr unsigned long max_node = 64;
+
+inline long set_mempolicy(int mode, const unsigned long* mask, unsigned long maxnode)
+{
+    return syscall(SYS_set_mempolicy, mode, mask, maxnode);
+}
+
+inline long mbind(void* p, unsigned long n, int mode, const unsigned long* mask,
+                  unsigned long maxnode, unsigned flags)
+{
+    return syscall(SYS_mbind, p, n, mode, mask, maxnode, flags);
+}
+
+}
+#endif
+
+/// Parses sysfs style lists such as "0-3,8,10-11"
+inline std::vector<unsigned> parse_list(const std::string& list)
+{
+    std::vector<unsigned> values;
+    std::size_t i = 0;
+
+    while(i < list.size())
+    {
+        std::size_t end;
+        unsigned first = std::stoul(list.substr(i), &end);
+        unsigned last = first;
+
+        i += end;
+
+        if(i < list.size() && list[i] == '-')
+        {
+            last = std::stoul(list.substr(++i), &end);
+            i += end;
+        }
+
+        for(unsigned v = first; v <= last; ++v) values.push_back(v);
+
+        // skip ',' and trailing newline alike
+        while(i < list.size() && (list[i] < '0' || list[i] > '9')) ++i;
+    }
+
+    return values;
+}
+
+inline std::string read_line(const std::string& path)
+{
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+/// \return nodes online, at least 1
+inline unsigned nodes()
+{
+#if __linux__
+    std::vector<unsigned> online = parse_list(read_line("/sys/devices/system/node/online"));
+
+    if(!online.empty()) return online.back() + 1;
+#endif
+    return 1;
+}
+
+/// \return CPUs belonging to 'node', empty if unknown
+inline std::vector<unsigned> cpus(int node)
+{
+#if __linux__
+    if(node >= 0)
+        return parse_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+#endif
+    return {};
+}
+
+/// \return node the calling thread is running on right now, or -1 if unknown
+inline int current()
+{
+#if __linux__
+    unsigned cpu, node;
+
+    if(syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return static_cast<int>(node);
+#endif
+    return -1;
+}
+
+/// \return node backing page at 'p', or -1 if unknown or not yet touched
+inline int of(const void* p)
+{
+#if __linux__
+    int node = -1;
+
+    if(syscall(SYS_get_mempolicy, &node, nullptr, 0, p,
+               sys::mpol_f_node | sys::mpol_f_addr) == 0)
+        return node;
+#endif
+    return -1;
+}
+
+/// Calling thread's allocations from here on prefer 'node', falling back elsewhere when full
+/// \return 0 on success, otherwise errno
+inline int prefer(int node)
+{
+#if __linux__
+    if(node < 0 || node >= int(sys::max_node)) return EINVAL;
+
+    unsigned long mask = 1UL << node;
+
+    if(sys::set_mempolicy(sys::mpol_preferred, &mask, sys::max_node) != 0) return errno;
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/// Prefers 'node' for every page overlapping [p, p + n), migrating those already touched
+/// @details Whole pages, so neighbours sharing them go along too
+/// \return 0 on success, otherwise errno
+inline int move(const void* p, std::size_t n, int node)
+{
+#if __linux__
+    if(node < 0 || node >= int(sys::max_node)) return EINVAL;
+
+    const std::uintptr_t page = sysconf(_SC_PAGESIZE);
+    std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(p) & ~(page - 1);
+    std::uintptr_t end = reinterpret_cast<std::uintptr_t>(p) + n;
+    unsigned long mask = 1UL << node;
+
+    if(sys::mbind(reinterpret_cast<void*>(begin), end - begin, sys::mpol_preferred,
+                    &mask, sys::max_node, sys::mpol_mf_move) != 0)
+        return errno;
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+
+/// Memory preferring one node, carved from large mappings and recycled by size class
+/// @details Mappings are placed on 'node' before first touch, so it doesn't matter which
+/// thread touches them first.  Nothing is handed back to the OS until destruction
+class Arena
+{
+    static constexpr std::size_t chunk_size = 256 * 1024;
+    static constexpr std::size_t min_class = 16;
+    // Beyond the largest class, allocations get a mapping of their own
+    static constexpr unsigned classes = 13;     // 16 bytes through 64KB
+
+    struct Free { Free* next; };
+
+    const int node_;
+
+    std::mutex mutex;
+    std::array<Free*, classes> free {};
+    std::vector<std::pair<void*, std::size_t> > mappings;
+    char* cursor = nullptr;
+    std::size_t remaining = 0;
+
+    static unsigned size_class(std::size_t n)
+    {
+        unsigned c = 0;
+        for(std::size_t size = min_class; size < n; size <<= 1) ++c;
+        return c;
+    }
+
+    static std::size_t class_size(unsigned c) { return min_class << c; }
+
+    void* map(std::size_t n)
+    {
+        void* p;
+#if __linux__
+        p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED) throw std::bad_alloc();
+
+        // Failure only costs locality, so carry on regardless
+        move(p, n, node_);
+#else
+        p = ::operator new(n);
+#endif
+        mappings.emplace_back(p, n);
+        return p;
+    }
+
+    void unmap(void* p, std::size_t n)
+    {
+#if __linux__
+        munmap(p, n);
+#else
+        ::operator delete(p);
+#endif
+    }
+
+public:
+    explicit Arena(int node) : node_(node) {}
+
+    Arena(const Arena&) = delete;
+
+    ~Arena()
+    {
+        for(auto& m : mappings) unmap(m.first, m.second);
+    }
+
+    int node() const { return node_; }
+
+    void* allocate(std::size_t n)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        unsigned c = size_class(n);
+
+        if(c >= classes) return map(n);
+
+        if(free[c] != nullptr)
+        {
+            Free* f = free[c];
+            free[c] = f->next;
+            return f;
+        }
+
+        std::size_t size = class_size(c);
+
+        if(remaining < size)
+        {
+            // DEBT: Tail of previous chunk is abandoned
+            cursor = static_cast<char*>(map(chunk_size));
+            remaining = chunk_size;
+        }
+
+        void* p = cursor;
+        cursor += size;
+        remaining -= size;
+        return p;
+    }
+
+    void deallocate(void* p, std::size_t n)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        unsigned c = size_class(n);
+
+        if(c >= classes)
+        {
+            auto i = std::find_if(mappings.begin(), mappings.end(),
+                [&](const std::pair<void*, std::size_t>& m) { return m.first == p; });
+
+            unmap(p, n);
+            mappings.erase(i);
+            return;
+        }
+
+        Free* f = static_cast<Free*>(p);
+        f->next = free[c];
+        free[c] = f;
+    }
+};
+
+
+/// Standard allocator drawing from an Arena on 'node', or the free store when node is -1
+/// @details Copies share one arena, so a container and its rebinds all stay on that node
+template <class T>
+class Allocator
+{
+    template <class U> friend class Allocator;
+
+    std::shared_ptr<Arena> arena;
+
+public:
+    typedef T value_type;
+
+    explicit Allocator(int node = -1) :
+        arena(node >= 0 ? std::make_shared<Arena>(node) : nullptr)
+    {}
+
+    template <class U>
+    Allocator(const Allocator<U>& copy_from) : arena(copy_from.arena) {}
+
+    int node() const { return arena ? arena->node() : -1; }
+
+    T* allocate(std::size_t n)
+    {
+        if(!arena) return static_cast<T*>(::operator new(n * sizeof(T)));
+
+        return static_cast<T*>(arena->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        if(!arena)
+            ::operator delete(p);
+        else
+            arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const Allocator<U>& rhs) const { return arena == rhs.arena; }
+
+    template <class U>
+    bool operator!=(const Allocator<U>& rhs) const { return arena != rhs.arena; }
+};
+
+
+/// Notes which node a thread settles on and where its traffic comes from
+class Tracker
+{
+    std::atomic<int> node_ {-1};
+    std::atomic<std::uint64_t> local_ {0};
+    std::atomic<std::uint64_t> remote_ {0};
+
+public:
+    /// Call from the tracked thread once placed
+    void started() { node_ = current(); }
+
+    /// Call from whichever thread hands the tracked one work
+    void arrived()
+    {
+        int node = node_;
+
+        if(node < 0) return;
+
+        if(current() == node)
+            ++local_;
+        else
+            ++remote_;
+    }
+
+    int node() const { return node_; }
+    std::uint64_t local() const { return local_; }
+    std::uint64_t remote() const { return remote_; }
+};
+
+}}}
@@ -0,0 +1,78 @@
+/**
+ * @file
+ * @brief Interruptible sleep on a condition variable
+ */
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+namespace moducom { namespace internal {
+
+/// Sleeps until a given time_point, unless woken first
+/// @details wakeup() only interrupts a sleep which would otherwise outlast the new wakeup,
+/// and a wake arriving while not asleep is remembered so the next sleep returns at once
+template <class TClock>
+class Sleeper
+{
+    typedef typename TClock::time_point time_point;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool woken = false;
+    bool asleep = false;
+    // While awake this stays at max, so that any wakeup arriving then is remembered
+    time_point sleepingUntil = time_point::max();
+
+public:
+    void wakeup(time_point t)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(t < sleepingUntil)
+        {
+            woken = true;
+            cv.notify_one();
+        }
+    }
+
+    void wake()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        woken = true;
+        cv.notify_one();
+    }
+
+    bool sleeping()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return asleep;
+    }
+
+    /// \param any when false, sleeps indefinitely
+    void sleep(bool any, time_point until)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Something arrived while we were busy, so go around again
+        if(woken)
+        {
+            woken = false;
+            return;
+        }
+
+        sleepingUntil = any ? until : time_point::max();
+        asleep = true;
+
+        if(any)
+            cv.wait_until(lock, until, [&] { return woken; });
+        else
+            cv.wait(lock, [&] { return woken; });
+
+        asleep = false;
+        woken = false;
+        sleepingUntil = time_point::max();
+    }
+};
+
+}}
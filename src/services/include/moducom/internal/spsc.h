@@ -0,0 +1,164 @@
+/**
+ * @file
+ * @brief Unbounded single-producer/single-consumer queue
+ * @details Slots come in fixed-size blocks linked as they fill.  Producer and consumer each keep
+ *          to their own end, meeting only on a per-slot flag, so neither ever waits on the
+ *          other.  One drained block is kept aside for the producer's next, so a queue which
+ *          keeps up with itself stops allocating after warming up
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace moducom { namespace internal {
+
+template <class T, std::size_t BlockSize = 64>
+class SpscQueue
+{
+public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+
+    static constexpr size_type block_size = BlockSize;
+
+private:
+    // Comfortably the cache line size of anything we run on
+    static constexpr size_type line = 64;
+
+    struct Slot
+    {
+        std::aligned_storage_t<sizeof(T), alignof(T)> raw;
+        std::atomic<bool> full {false};
+
+        T& value() { return reinterpret_cast<T&>(raw); }
+    };
+
+    struct Block
+    {
+        std::array<Slot, block_size> slots;
+        std::atomic<Block*> next {nullptr};
+    };
+
+    // Consumer's end
+    alignas(line) Block* head;
+    size_type headIndex = 0;
+
+    // Producer's end
+    alignas(line) Block* tail;
+    size_type tailIndex = 0;
+
+    // Handed back by consumer, picked up by producer
+    alignas(line) std::atomic<Block*> spare {nullptr};
+
+    Block* acquire()
+    {
+        Block* b = spare.exchange(nullptr, std::memory_order_acquire);
+
+        if(b == nullptr) return new Block;
+
+        b->next.store(nullptr, std::memory_order_relaxed);
+        return b;
+    }
+
+    void release(Block* b)
+    {
+        Block* expected = nullptr;
+
+        if(!spare.compare_exchange_strong(expected, b, std::memory_order_release))
+            delete b;
+    }
+
+public:
+    SpscQueue() : head(new Block), tail(head) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue()
+    {
+        while(consume([](T&) {}));
+
+        delete head;
+        delete spare.load();
+    }
+
+    /// Producer only.  Never fails, allocating a block if need be
+    template <class ...TArgs>
+    void emplace(TArgs&&...args)
+    {
+        if(tailIndex == block_size)
+        {
+            Block* b = acquire();
+
+            tail->next.store(b, std::memory_order_release);
+            tail = b;
+            tailIndex = 0;
+        }
+
+        Slot& slot = tail->slots[tailIndex++];
+
+        ::new ((void*) std::addressof(slot.raw)) T(std::forward<TArgs>(args)...);
+        slot.full.store(true, std::memory_order_release);
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    /// Consumer only.  Takes the oldest item off before handing it to 'f', so 'f' may throw
+    /// \return false if nothing was waiting
+    template <class F>
+    bool consume(F&& f)
+    {
+        if(headIndex == block_size)
+        {
+            Block* next = head->next.load(std::memory_order_acquire);
+
+            if(next == nullptr) return false;
+
+            release(head);
+            head = next;
+            headIndex = 0;
+        }
+
+        Slot& slot = head->slots[headIndex];
+
+        if(!slot.full.load(std::memory_order_acquire)) return false;
+
+        T value(std::move(slot.value()));
+
+        slot.value().~T();
+        // Ready for reuse, should this block come back around as a spare
+        slot.full.store(false, std::memory_order_relaxed);
+        ++headIndex;
+
+        f(value);
+        return true;
+    }
+
+    /// Consumer only
+    /// \return false if nothing was waiting
+    bool pop(T& out)
+    {
+        return consume([&](T& value) { out = std::move(value); });
+    }
+
+    /// Consumer only
+    bool empty()
+    {
+        if(headIndex == block_size)
+        {
+            Block* next = head->next.load(std::memory_order_acquire);
+            return next == nullptr || !next->slots[0].full.load(std::memory_order_acquire);
+        }
+
+        return !head->slots[headIndex].full.load(std::memory_order_acquire);
+    }
+};
+
+}}
@@ -0,0 +1,315 @@
+/**
+ * @file
+ * @brief Hierarchical timing wheel
+ * @details Per Varghese & Lauck "Hashed and Hierarchical Timing Wheels".  64 slots per level
+ *          and enough levels to cover the full 64-bit tick range, so there is no overflow list.
+ *          Insert and erase are O(1).  Advancing jumps straight to the next occupied slot
+ *          rather than stepping through every tick, and each node cascades down at most once
+ *          per level over its lifetime
+ */
+#pragma once
+
+#include "bits.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace moducom { namespace internal {
+
+template <class T>
+class TimerWheel
+{
+public:
+    typedef T value_type;
+    typedef std::uint64_t tick_type;
+    typedef std::uint32_t index_type;
+    /// bumped each time a node is freed, so stale references to it can be told apart
+    typedef std::uint32_t generation_type;
+
+    static constexpr index_type npos = ~index_type(0);
+
+    static constexpr unsigned slot_bits = 6;
+    static constexpr unsigned slots = 1 << slot_bits;
+    static constexpr unsigned levels = (64 + slot_bits - 1) / slot_bits;
+
+private:
+    struct Node
+    {
+        value_type value;
+        tick_type tick;
+        index_type prev;
+        index_type next;
+        generation_type generation;
+        unsigned char level;
+        unsigned char slot;
+        bool linked;
+        bool allocated;
+    };
+
+    std::vector<Node> nodes;
+    index_type free_ = npos;
+    std::size_t size_ = 0;
+
+    index_type heads[levels][slots];
+    std::uint64_t occupied[levels] = {};
+
+    tick_type now_ = 0;
+
+    void place(index_type i)
+    {
+        Node& n = nodes[i];
+
+        // Anything in the past is filed under 'now'
+        if(n.tick < now_) n.tick = now_;
+
+        tick_type diff = n.tick ^ now_;
+        unsigned level = diff == 0 ? 0 : bits::msb(diff) / slot_bits;
+        unsigned slot = (n.tick >> (level * slot_bits)) & (slots - 1);
+
+        n.level = level;
+        n.slot = slot;
+        n.prev = npos;
+        n.next = heads[level][slot];
+        n.linked = true;
+
+        if(n.next != npos) nodes[n.next].prev = i;
+
+        heads[level][slot] = i;
+        occupied[level] |= std::uint64_t(1) << slot;
+    }
+
+    /// Locates earliest occupied slot
+    /// \return false if wheel is empty
+    bool earliest_slot(unsigned& level, unsigned& slot, tick_type& start) const
+    {
+        for(level = 0; level < levels; ++level)
+        {
+            if(occupied[level] == 0) continue;
+
+            slot = bits::ctz(occupied[level]);
+
+            unsigned shift = level * slot_bits;
+            unsigned above = shift + slot_bits;
+            // Everything at this level shares bits above it with 'now'
+            tick_type block = above >= 64 ? 0 : (now_ >> above) << above;
+
+            start = block | (tick_type(slot) << shift);
+            return true;
+        }
+
+        return false;
+    }
+
+    /// Detaches whole list at [level][slot]
+    index_type take(unsigned level, unsigned slot)
+    {
+        index_type i = heads[level][slot];
+
+        heads[level][slot] = npos;
+        occupied[level] &= ~(std::uint64_t(1) << slot);
+
+        for(index_type j = i; j != npos; j = nodes[j].next)
+            nodes[j].linked = false;
+
+        return i;
+    }
+
+public:
+    TimerWheel()
+    {
+        for(auto& level : heads)
+            for(index_type& head : level)
+                head = npos;
+    }
+
+    tick_type now() const { return now_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void reserve(std::size_t n) { nodes.reserve(n); }
+
+    value_type& operator[](index_type i) { return nodes[i].value; }
+    const value_type& operator[](index_type i) const { return nodes[i].value; }
+
+    tick_type tick(index_type i) const { return nodes[i].tick; }
+    bool linked(index_type i) const { return nodes[i].linked; }
+    generation_type generation(index_type i) const { return nodes[i].generation; }
+
+    /// Allocates a node holding 'value' and files it under 'tick'
+    index_type insert(tick_type tick, const value_type& value)
+    {
+        index_type i = allocate(value);
+        link(i, tick);
+        return i;
+    }
+
+    /// Allocates a node holding 'value' without filing it anywhere
+    index_type allocate(const value_type& value)
+    {
+        index_type i;
+
+        if(free_ != npos)
+        {
+            i = free_;
+            free_ = nodes[i].next;
+            nodes[i].value = value;
+        }
+        else
+        {
+            i = static_cast<index_type>(nodes.size());
+            nodes.push_back(Node{value, 0, npos, npos, 0, 0, 0, false, false});
+        }
+
+        nodes[i].allocated = true;
+        nodes[i].linked = false;
+        ++size_;
+        return i;
+    }
+
+    void link(index_type i, tick_type tick)
+    {
+        nodes[i].tick = tick;
+        place(i);
+    }
+
+    void unlink(index_type i)
+    {
+        Node& n = nodes[i];
+
+        if(!n.linked) return;
+
+        if(n.prev != npos)
+            nodes[n.prev].next = n.next;
+        else
+        {
+            heads[n.level][n.slot] = n.next;
+            if(n.next == npos)
+                occupied[n.level] &= ~(std::uint64_t(1) << n.slot);
+        }
+
+        if(n.next != npos) nodes[n.next].prev = n.prev;
+
+        n.linked = false;
+    }
+
+    /// Unlinks (if necessary) and frees node
+    void erase(index_type i)
+    {
+        unlink(i);
+        nodes[i].allocated = false;
+        ++nodes[i].generation;
+        nodes[i].next = free_;
+        free_ = i;
+        --size_;
+    }
+
+    bool allocated(index_type i) const
+    {
+        return i < nodes.size() && nodes[i].allocated;
+    }
+
+    /// Visits every allocated node, filed or not
+    /// \param f void(index_type, const value_type&)
+    template <class F>
+    void each(F&& f) const
+    {
+        for(index_type i = 0; i < nodes.size(); ++i)
+            if(nodes[i].allocated) f(i, nodes[i].value);
+    }
+
+    /// \param less strict ordering applied within the earliest slot
+    /// \return earliest node, or npos if empty
+    template <class Less>
+    index_type earliest(Less&& less) const
+    {
+        unsigned level, slot;
+        tick_type start;
+
+        if(!earliest_slot(level, slot, start)) return npos;
+
+        index_type best = heads[level][slot];
+
+        for(index_type j = nodes[best].next; j != npos; j = nodes[j].next)
+            if(less(nodes[j].value, nodes[best].value)) best = j;
+
+        return best;
+    }
+
+    /// Tick of earliest occupied slot.  For upper levels this is the start of that slot's range
+    bool earliest_tick(tick_type& tick) const
+    {
+        unsigned level, slot;
+        return earliest_slot(level, slot, tick);
+    }
+
+    /// Moves 'now' forward to 'target', handing every node filed at or before it to 'expire'
+    /// @details Nodes filed exactly at 'target' are only expired if 'due' agrees, which lets
+    /// callers keep sub-tick precision.  Expired nodes are unlinked but stay allocated, so
+    /// caller decides whether to erase or re-link them
+    /// \param due bool(index_type)
+    /// \param expire void(index_type)
+    template <class Due, class Expire>
+    void advance(tick_type target, Due&& due, Expire&& expire)
+    {
+        if(target < now_) target = now_;
+
+        unsigned level, slot;
+        tick_type start;
+
+        while(earliest_slot(level, slot, start) && start <= target)
+        {
+            now_ = start;
+
+            if(level > 0)
+            {
+                // cascade: re-file relative to new 'now', which lands each node at a lower level
+                index_type i = take(level, slot);
+
+                while(i != npos)
+                {
+                    index_type next = nodes[i].next;
+                    place(i);
+                    i = next;
+                }
+            }
+            else if(start < target)
+            {
+                index_type i = take(level, slot);
+
+                while(i != npos)
+                {
+                    index_type next = nodes[i].next;
+                    expire(i);
+                    i = next;
+                }
+            }
+            else
+            {
+                // boundary slot, only pluck out what 'due' says is ready
+                index_type i = heads[level][slot];
+
+                while(i != npos)
+                {
+                    index_type next = nodes[i].next;
+
+                    if(due(i))
+                    {
+                        unlink(i);
+                        expire(i);
+                    }
+
+                    i = next;
+                }
+
+                break;
+            }
+        }
+
+        // Safe to jump, since anything left is filed strictly after 'target'
+        // (or at 'target' itself and not yet due)
+        now_ = target;
+    }
+};
+
+}}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstring>
+
 namespace moducom {
 
 struct SemVer
@@ -8,7 +10,33 @@ struct SemVer
     const unsigned short minor;
     const unsigned short patch;
 
-    const char* prerelease;
+    /// nullptr for a normal (non prerelease) version
+    const char* prerelease = nullptr;
 };
 
-}
\ No newline at end of file
+/// Orders per semver.org precedence, except that prerelease identifiers are compared as
+/// plain strings rather than dot separated fields
+inline bool operator <(const SemVer& lhs, const SemVer& rhs)
+{
+    if(lhs.major != rhs.major) return lhs.major < rhs.major;
+    if(lhs.minor != rhs.minor) return lhs.minor < rhs.minor;
+    if(lhs.patch != rhs.patch) return lhs.patch < rhs.patch;
+
+    // a prerelease version has lower precedence than its associated normal version
+    if(lhs.prerelease == nullptr) return false;
+    if(rhs.prerelease == nullptr) return true;
+
+    return std::strcmp(lhs.prerelease, rhs.prerelease) < 0;
+}
+
+inline bool operator ==(const SemVer& lhs, const SemVer& rhs)
+{
+    return !(lhs < rhs) && !(rhs < lhs);
+}
+
+inline bool operator !=(const SemVer& lhs, const SemVer& rhs) { return !(lhs == rhs); }
+inline bool operator >(const SemVer& lhs, const SemVer& rhs) { return rhs < lhs; }
+inline bool operator <=(const SemVer& lhs, const SemVer& rhs) { return !(rhs < lhs); }
+inline bool operator >=(const SemVer& lhs, const SemVer& rhs) { return !(lhs < rhs); }
+
+}
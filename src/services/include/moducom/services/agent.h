@@ -17,6 +17,7 @@
 
 #include "status.h"
 #include "description.h"
+#include "thread.h"
 
 namespace moducom { namespace services { namespace agents {
 
@@ -54,6 +55,8 @@ class Agent
     entt::sigh<void(Agent*, Progress)> progressSignal_;
     entt::sigh<void(Agent*, Alert)> alertSignal_;
 
+    moducom::internal::numa::Tracker tracker_;
+
 protected:
     typedef agents::EnttHelper EnttHelper;
 
@@ -105,9 +108,67 @@ public:
         alertSignal_.publish(this, Alert{message, subsystem, Alert::Error});
     }
 
+    /// Overrides thread attributes for this agent, taking effect from its next run()
+    void threadAttributes(const ThreadAttributes& attributes)
+    {
+        entity.registry.emplace_or_replace<ThreadAttributes>(entity.entity, attributes);
+    }
+
+    /// Attributes configured for this agent, if any, named after its Description when
+    /// not named already
+    ThreadAttributes threadAttributes() const
+    {
+        const ThreadAttributes* configured = configuredThreadAttributes();
+        ThreadAttributes attributes = configured ? *configured : ThreadAttributes();
+
+        if(attributes.name.empty())
+        {
+            const Description* d = entity.registry.try_get<Description>(entity.entity);
+            if(d != nullptr) attributes.name = d->name();
+        }
+
+        return attributes;
+    }
+
+protected:
+    const ThreadAttributes* configuredThreadAttributes() const
+    {
+        return entity.registry.try_get<ThreadAttributes>(entity.entity);
+    }
+
+    /// Applies 'attributes' to the calling thread.  Failure is reported through error()
+    /// rather than holding the thread up
+    void applyThreadAttributes(const ThreadAttributes& attributes)
+    {
+        if(!attributes.defaults())
+        {
+            std::string errors = internal::apply(attributes);
+
+            if(!errors.empty()) error(errors, "thread");
+        }
+
+        tracker_.started();
+    }
+
+    /// Call from whichever thread hands this agent work, so placement() can tell
+    /// whether it came from near or far
+    void arrived() { tracker_.arrived(); }
+
 public:
     Status status() const { return status_; }
 
+    /// Where this agent's thread landed and where its work came from.  'memory' is
+    /// left to agents which know where their service lives
+    NumaPlacement placement() const
+    {
+        NumaPlacement p;
+
+        p.thread = tracker_.node();
+        p.local = tracker_.local();
+        p.remote = tracker_.remote();
+        return p;
+    }
+
     const Description& description() const
     {
         return entity.get<Description>();
@@ -0,0 +1,532 @@
+/**
+ * @file
+ * @brief Coroutine agent, whose service run() is a C++20 coroutine
+ * @details Lets multi-step services (handshakes, retry with backoff) read top to bottom without
+ *          tying up a thread or hand rolling a state machine.  A suspended coroutine costs only
+ *          its frame, and is resumed by whichever executor started it.  Requires C++20 and
+ *          FEATURE_MC_SERVICES_ENTT_STOPTOKEN, and is compiled out otherwise
+ */
+#pragma once
+
+#include "scheduler.hpp"
+
+// Awaiting stop needs stop_callback, which only the EnTT flavor of stop_token has
+#ifndef FEATURE_MC_SERVICES_COROUTINE
+#if __cpp_impl_coroutine && FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+#define FEATURE_MC_SERVICES_COROUTINE 1
+#else
+#define FEATURE_MC_SERVICES_COROUTINE 0
+#endif
+#endif
+
+#if FEATURE_MC_SERVICES_COROUTINE
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+
+namespace moducom { namespace services { namespace agents {
+
+namespace coro {
+
+/// Whatever resumes coroutines, i.e. CooperativeExecutor
+template <class TClock>
+class Resumer
+{
+public:
+    typedef TClock clock_type;
+    typedef typename clock_type::time_point time_point;
+    typedef managers::Scheduler<time_point, typename clock_type::duration> scheduler_type;
+
+    /// Resume 'h' on resumer's thread at next opportunity.  Thread safe
+    virtual void post(std::coroutine_handle<> h) = 0;
+
+    /// Where coroutine timers live
+    virtual scheduler_type& timers() = 0;
+
+    /// A coroutine started on this resumer ran to completion.  Called on resumer's thread
+    virtual void finished() = 0;
+};
+
+/// Return type of a coroutine service's run()
+/// @details Starts suspended.  Coroutine agent hands it a resumer and stop token, then
+/// posts it to begin
+template <class TClock = std::chrono::steady_clock>
+class Task
+{
+public:
+    struct promise_type
+    {
+        Resumer<TClock>* resumer = nullptr;
+        stop_token token;
+        Agent* agent = nullptr;
+        std::exception_ptr error;
+
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct Finished
+        {
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                promise_type& p = h.promise();
+                if(p.agent) p.agent->status(p.error ? Status::Error : Status::Stopped);
+                if(p.resumer) p.resumer->finished();
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        // Stays suspended at the end so that Task can still see done()
+        Finished final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+
+        void unhandled_exception()
+        {
+            error = std::current_exception();
+        }
+    };
+
+    typedef std::coroutine_handle<promise_type> handle_type;
+
+private:
+    handle_type h;
+
+public:
+    explicit Task(handle_type h = nullptr) : h(h) {}
+
+    Task(Task&& move_from) noexcept : h(move_from.h)
+    {
+        move_from.h = nullptr;
+    }
+
+    Task& operator=(Task&& move_from) noexcept
+    {
+        if(this != &move_from)
+        {
+            if(h) h.destroy();
+            h = move_from.h;
+            move_from.h = nullptr;
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+
+    ~Task()
+    {
+        if(h) h.destroy();
+    }
+
+    handle_type handle() const { return h; }
+
+    bool done() const { return !h || h.done(); }
+
+    /// Exception which escaped coroutine, if any
+    std::exception_ptr error() const { return h ? h.promise().error : nullptr; }
+};
+
+namespace internal {
+
+template <class TClock>
+using promise_handle = std::coroutine_handle<typename Task<TClock>::promise_type>;
+
+/// Posts 'h' exactly once, no matter how many parties race to wake it
+template <class TClock>
+struct Wakeup
+{
+    std::atomic<bool> claimed {false};
+    std::coroutine_handle<> h;
+    Resumer<TClock>* resumer = nullptr;
+
+    bool claim() { return !claimed.exchange(true); }
+
+    void operator()()
+    {
+        if(claim()) resumer->post(h);
+    }
+};
+
+/// One coroutine parked until another thread hands it something, or stop is requested.
+/// Whichever comes first posts it
+/// @details Owner guards both its payload and us with 'mutex'
+template <class TClock>
+class Waiter
+{
+    struct WakeOnStop
+    {
+        Waiter* parent;
+
+        void operator()() const
+        {
+            Resumer<TClock>* r;
+            std::coroutine_handle<> h;
+
+            {
+                std::lock_guard<std::mutex> lock(parent->mutex);
+                h = parent->claim(r);
+            }
+
+            if(h) r->post(h);
+        }
+    };
+
+    std::mutex& mutex;
+    std::coroutine_handle<> waiting;
+    Resumer<TClock>* resumer = nullptr;
+    std::optional<stop_callback<WakeOnStop> > stopCallback;
+
+public:
+    explicit Waiter(std::mutex& mutex) : mutex(mutex) {}
+
+    /// Parks 'h' unless 'ready()' under lock, or stop is already requested
+    /// \return false if 'h' should carry on without suspending
+    template <class F>
+    bool park(promise_handle<TClock> h, F&& ready)
+    {
+        auto& promise = h.promise();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(ready() || promise.token.stop_requested()) return false;
+
+            waiting = h;
+            resumer = promise.resumer;
+        }
+
+        // 'h' only resumes on this very thread, so stays put until we return even if
+        // already posted.  Stop arriving before the callback is in place runs it right here
+        if(promise.token.stop_possible())
+            stopCallback.emplace(promise.token, WakeOnStop{this});
+
+        return true;
+    }
+
+    /// Takes parked coroutine, if any, for caller to post once unlocked.  Lock held
+    std::coroutine_handle<> claim(Resumer<TClock>*& r)
+    {
+        std::coroutine_handle<> h = waiting;
+
+        r = resumer;
+        waiting = nullptr;
+        return h;
+    }
+
+    /// Once resumed and before taking lock.  Waits out a stop callback still running
+    /// on another thread
+    void resumed() { stopCallback.reset(); }
+};
+
+}
+
+/// Awaitable which resumes after a delay, or early once stop is requested
+/// \return true if woken by stop request rather than time
+template <class TClock = std::chrono::steady_clock>
+class Sleep : public PeriodicBase<typename TClock::duration>
+{
+    typedef typename TClock::duration duration_type;
+    typedef typename TClock::time_point time_point;
+    typedef typename Resumer<TClock>::scheduler_type scheduler_type;
+
+    // Once posted, the coroutine may resume and tear down our stop_callback while
+    // request_stop() is still publishing on the other thread.  Teardown waits that out
+    struct WakeOnStop
+    {
+        Sleep* parent;
+
+        void operator()() const
+        {
+            if(parent->wakeup.claim())
+            {
+                parent->timer.cancel();
+                parent->stopped = true;
+                parent->wakeup.resumer->post(parent->wakeup.h);
+            }
+        }
+    };
+
+    const time_point when;
+    internal::Wakeup<TClock> wakeup;
+    typename scheduler_type::handle_type timer;
+    std::optional<stop_callback<WakeOnStop> > stopCallback;
+    bool stopped = false;
+
+public:
+    explicit Sleep(time_point when) : when(when) {}
+
+    // Timer expired, from resumer's scheduler
+    duration_type run(duration_type) override
+    {
+        wakeup();
+        return duration_type::min();
+    }
+
+    bool await_ready() const { return false; }
+
+    bool await_suspend(internal::promise_handle<TClock> h)
+    {
+        auto& promise = h.promise();
+
+        if(promise.token.stop_requested())
+        {
+            stopped = true;
+            return false;
+        }
+
+        wakeup.h = h;
+        wakeup.resumer = promise.resumer;
+
+        // Timer goes in first, so that a stop request always has something to cancel
+        timer = promise.resumer->timers().add(this, when, TClock::now());
+
+        if(promise.token.stop_possible())
+        {
+            stopCallback.emplace(promise.token, WakeOnStop{this});
+
+            // Stop arrived before our callback was in place.  Timer can't have fired yet,
+            // since it only does so on this very thread
+            if(promise.token.stop_requested() && wakeup.claim())
+            {
+                timer.cancel();
+                stopCallback.reset();
+                stopped = true;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool await_resume() const { return stopped; }
+};
+
+template <class TClock = std::chrono::steady_clock, class Rep, class Period>
+Sleep<TClock> sleep_for(std::chrono::duration<Rep, Period> d)
+{
+    return Sleep<TClock>(TClock::now() + std::chrono::duration_cast<typename TClock::duration>(d));
+}
+
+template <class TClock = std::chrono::steady_clock>
+Sleep<TClock> sleep_until(typename TClock::time_point when)
+{
+    return Sleep<TClock>(when);
+}
+
+
+/// Awaitable which resumes once stop is requested
+template <class TClock = std::chrono::steady_clock>
+class Stopped
+{
+    internal::Wakeup<TClock> wakeup;
+    std::optional<stop_callback<std::reference_wrapper<internal::Wakeup<TClock> > > > stopCallback;
+
+public:
+    bool await_ready() const { return false; }
+
+    bool await_suspend(internal::promise_handle<TClock> h)
+    {
+        auto& promise = h.promise();
+
+        wakeup.h = h;
+        wakeup.resumer = promise.resumer;
+
+        // Never going to happen, so don't wait around
+        if(!promise.token.stop_possible()) return false;
+
+        stopCallback.emplace(promise.token, std::ref(wakeup));
+
+        // Stop arrived before our callback was in place
+        if(promise.token.stop_requested() && wakeup.claim())
+        {
+            stopCallback.reset();
+            return false;
+        }
+
+        return true;
+    }
+
+    void await_resume() const {}
+};
+
+template <class TClock = std::chrono::steady_clock>
+Stopped<TClock> stopped() { return {}; }
+
+
+/// Awaitable which yields this coroutine's stop token without suspending
+template <class TClock = std::chrono::steady_clock>
+class Token
+{
+    stop_token token;
+
+public:
+    bool await_ready() const { return false; }
+
+    bool await_suspend(internal::promise_handle<TClock> h)
+    {
+        token = h.promise().token;
+        return false;
+    }
+
+    stop_token await_resume() const { return token; }
+};
+
+template <class TClock = std::chrono::steady_clock>
+Token<TClock> token() { return {}; }
+
+
+/// Queue of events from any thread, awaited by one coroutine
+/// @details A stop request wakes the waiting coroutine too, in which case next() yields
+/// nothing.  Events already queued are still handed out first
+template <class T, class TClock = std::chrono::steady_clock>
+class Channel
+{
+    std::mutex mutex;
+    std::deque<T> queue;
+    internal::Waiter<TClock> waiter {mutex};
+
+    class Next
+    {
+        Channel& parent;
+
+    public:
+        Next(Channel& parent) : parent(parent) {}
+
+        bool await_ready() const { return false; }
+
+        bool await_suspend(internal::promise_handle<TClock> h)
+        {
+            return parent.waiter.park(h, [&] { return !parent.queue.empty(); });
+        }
+
+        /// \return empty if woken by stop request
+        std::optional<T> await_resume()
+        {
+            parent.waiter.resumed();
+
+            std::lock_guard<std::mutex> lock(parent.mutex);
+
+            if(parent.queue.empty()) return std::nullopt;
+
+            std::optional<T> value(std::move(parent.queue.front()));
+            parent.queue.pop_front();
+            return value;
+        }
+    };
+
+public:
+    /// Thread safe
+    template <class ...TArgs>
+    void emplace(TArgs&&...args)
+    {
+        std::coroutine_handle<> h;
+        Resumer<TClock>* r;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.emplace_back(std::forward<TArgs>(args)...);
+            h = waiter.claim(r);
+        }
+
+        if(h) r->post(h);
+    }
+
+    void push(const T& value) { emplace(value); }
+
+    /// co_await to receive next event, or nothing once stop is requested
+    Next next() { return Next(*this); }
+};
+
+
+/// One-shot result from any thread, such as a transfer completion callback, awaited by
+/// one coroutine
+/// @details A stop request wakes the waiting coroutine too, in which case it yields nothing
+template <class T, class TClock = std::chrono::steady_clock>
+class Completion
+{
+    std::mutex mutex;
+    std::optional<T> value;
+    internal::Waiter<TClock> waiter {mutex};
+
+public:
+    /// Thread safe
+    void complete(T v)
+    {
+        std::coroutine_handle<> h;
+        Resumer<TClock>* r;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            value.emplace(std::move(v));
+            h = waiter.claim(r);
+        }
+
+        if(h) r->post(h);
+    }
+
+    bool await_ready() const { return false; }
+
+    bool await_suspend(internal::promise_handle<TClock> h)
+    {
+        return waiter.park(h, [&] { return value.has_value(); });
+    }
+
+    /// \return empty if woken by stop request before completion
+    std::optional<T> await_resume()
+    {
+        waiter.resumed();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::move(value);
+    }
+};
+
+}
+
+/// Agent whose service run() is a coroutine returning coro::Task<TClock>
+/// @details Never blocks a thread of its own.  Resumed only on its resumer's thread, so the
+/// service needs no locking of its own.  Be sure the coroutine has finished (i.e. stop requested
+/// and resumer joined) before this agent goes away
+template <class TService, class TClock = std::chrono::steady_clock>
+class Coroutine : public Base<TService>
+{
+    typedef Base<TService> base_type;
+
+    coro::Task<TClock> task;
+
+public:
+    typedef coro::Resumer<TClock> resumer_type;
+
+    Coroutine(EnttHelper eh) : base_type(eh) {}
+
+    /// Begins service run() on 'resumer', which then owns all further resumption
+    void start(resumer_type& resumer, const stop_token& token)
+    {
+        task = base_type::service().run();
+
+        auto& promise = task.handle().promise();
+        promise.resumer = &resumer;
+        promise.token = token;
+        promise.agent = this;
+
+        base_type::status(Status::Running);
+        resumer.post(task.handle());
+    }
+
+    bool done() const { return task.done(); }
+
+    std::exception_ptr error() const { return task.error(); }
+};
+
+}}}
+
+#endif
@@ -22,6 +22,9 @@ public:
         new (this) Description(copyFrom);
         return *this;
     };
+
+    const char* name() const { return name_; }
+    const SemVer& version() const { return version_; }
 };
 
 }}
\ No newline at end of file
@@ -0,0 +1,144 @@
+/**
+ * @file
+ * @brief Central, typed event bus
+ * @details Services subscribe by the event type their run() takes, rather than being wired to
+ *          each source's sigh by hand.  Routing is settled at compile time, so publishing is
+ *          a walk over that one event type's subscribers with no lookup or virtual call
+ */
+#pragma once
+
+#include "../../../agents.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace moducom { namespace services { namespace managers {
+
+namespace internal {
+
+/// Event type TService::run() handles, deduced via ArgType
+template <class TService>
+struct event_of
+{
+    typedef typename moducom::internal::ArgType<decltype(&TService::run)>::tuple_type args_type;
+
+    static_assert(std::tuple_size<args_type>::value == 1,
+                  "EventBus subscribers take exactly one event in run()");
+
+    typedef std::decay_t<std::tuple_element_t<0, args_type> > type;
+};
+
+template <class TService>
+using event_of_t = typename event_of<TService>::type;
+
+template <class E, class ...TEvents>
+constexpr bool one_of() { return (std::is_same<E, TEvents>::value || ...); }
+
+/// Every subscriber to one event type, in subscription order
+template <class E>
+class Route
+{
+    // Function pointer plus instance, in the spirit of entt::delegate
+    struct Subscriber
+    {
+        void* instance;
+        void (*deliver)(void*, const E&);
+    };
+
+    std::vector<Subscriber> subscribers;
+
+    template <class TAgent>
+    static void deliver(void* instance, const E& e)
+    {
+        static_cast<TAgent*>(instance)->run(e);
+    }
+
+public:
+    template <class TAgent>
+    void add(TAgent& agent)
+    {
+        subscribers.push_back(Subscriber{&agent, &deliver<TAgent>});
+    }
+
+    /// \return false if 'instance' wasn't subscribed
+    bool remove(void* instance)
+    {
+        auto i = std::find_if(subscribers.begin(), subscribers.end(),
+            [&](const Subscriber& s) { return s.instance == instance; });
+
+        if(i == subscribers.end()) return false;
+
+        subscribers.erase(i);
+        return true;
+    }
+
+    std::size_t size() const { return subscribers.size(); }
+
+    void publish(const E& e) const
+    {
+        for(const Subscriber& s : subscribers) s.deliver(s.instance, e);
+    }
+};
+
+}
+
+/// Routes each of 'TEvents' to whichever agents' services handle it
+/// @details Agents subscribe with the event type deduced from their service's run(), so any
+/// agent exposing run(event) fits.  Event agents handle it right on the publishing thread,
+/// while AsyncEventQueue agents queue it for their own, and the two mix freely on one event
+/// type.  Only queued subscribers may be published to from several threads at once.
+/// Subscribing is not thread safe, so settle subscriptions before publishing begins
+/// \tparam TEvents every event type this bus carries
+template <class ...TEvents>
+class EventBus
+{
+    std::tuple<internal::Route<TEvents>...> routes;
+
+    template <class E>
+    internal::Route<E>& route()
+    {
+        static_assert(internal::one_of<E, TEvents...>(), "EventBus doesn't carry this event type");
+
+        return std::get<internal::Route<E> >(routes);
+    }
+
+    template <class E>
+    const internal::Route<E>& route() const
+    {
+        static_assert(internal::one_of<E, TEvents...>(), "EventBus doesn't carry this event type");
+
+        return std::get<internal::Route<E> >(routes);
+    }
+
+public:
+    /// Delivers every event of the type 'agent's service run() takes from here on
+    /// \tparam TAgent Event, AsyncEventQueue or anything else exposing service_type and run()
+    template <class TAgent>
+    void subscribe(TAgent& agent)
+    {
+        route<internal::event_of_t<typename TAgent::service_type> >().add(agent);
+    }
+
+    /// \return false if 'agent' wasn't subscribed
+    template <class TAgent>
+    bool unsubscribe(TAgent& agent)
+    {
+        return route<internal::event_of_t<typename TAgent::service_type> >().remove(&agent);
+    }
+
+    /// Number of agents subscribed to 'E'
+    template <class E>
+    std::size_t subscribers() const { return route<E>().size(); }
+
+    /// Hands 'e' to every agent subscribed to E, in subscription order
+    template <class E>
+    void publish(const E& e) const
+    {
+        route<E>().publish(e);
+    }
+};
+
+}}}
@@ -0,0 +1,350 @@
+#pragma once
+
+#include "scheduler.hpp"
+#include "coroutine.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace moducom { namespace services { namespace managers {
+
+namespace internal {
+
+/// Idle::time_point as seen by TClock, leaving min() and max() as they are
+template <class TClock>
+typename TClock::time_point from_idle(agents::Idle::time_point t)
+{
+    typedef typename TClock::time_point time_point;
+
+    if constexpr (std::is_same<time_point, agents::Idle::time_point>::value)
+        return t;
+    else
+    {
+        if(t == agents::Idle::time_point::min()) return time_point::min();
+        if(t == agents::Idle::time_point::max()) return time_point::max();
+
+        return TClock::now() + std::chrono::duration_cast<typename TClock::duration>(
+            t - agents::Idle::clock_type::now());
+    }
+}
+
+template <class TClock, class TAgent>
+auto step_due(TAgent& agent, int) -> decltype(from_idle<TClock>(agent.due()))
+{
+    return from_idle<TClock>(agent.due());
+}
+
+/// TAgent has no due(), so wants stepping every pass
+template <class TClock, class TAgent>
+typename TClock::time_point step_due(TAgent&, ...) { return TClock::time_point::min(); }
+
+template <class TAgent>
+auto step_waker(TAgent& agent, std::function<void ()> f, int) -> decltype(agent.waker(f))
+{
+    agent.waker(std::move(f));
+}
+
+/// TAgent can't be woken
+template <class TAgent>
+void step_waker(TAgent&, std::function<void ()>, ...) {}
+
+}
+
+/// Runs many agents on one shared thread through an event/timer loop, handing out
+/// dedicated threads only to those whose service needs one
+/// @details Each pass runs anything posted, then whatever timers are due, then one step of
+/// each cooperative agent which is due.  A cooperative agent is due per the Idle its
+/// service's run() last returned, or always if that returns void.  Until something is due,
+/// the thread sleeps, unless woken by post(), place() or an agent's wake().  Under C++20
+/// this also resumes coroutine agents
+template <class TClock = std::chrono::steady_clock>
+class CooperativeExecutor : public Agent
+#if FEATURE_MC_SERVICES_COROUTINE
+        , public agents::coro::Resumer<TClock>
+#endif
+{
+public:
+    typedef TClock clock_type;
+    typedef typename clock_type::time_point time_point;
+    typedef typename clock_type::duration duration_type;
+    typedef Scheduler<time_point, duration_type> scheduler_type;
+    typedef typename scheduler_type::agent_type periodic_type;
+    typedef typename scheduler_type::handle_type handle_type;
+    typedef std::function<void ()> task_type;
+
+private:
+    typedef CooperativeExecutor this_type;
+
+    struct Stepper
+    {
+        /// \return false once agent needs no more steps
+        std::function<bool (const stop_token&)> step;
+        /// when agent next wants a step
+        std::function<time_point ()> due;
+    };
+
+    scheduler_type scheduler_;
+    internal::Sleeper<clock_type> sleeper;
+
+    std::mutex mutex;
+    std::vector<task_type> posted;
+    // placed since last pass.  Only the executor thread itself touches 'steppers'
+    std::vector<Stepper> arriving;
+    std::vector<Stepper> steppers;
+
+    std::vector<std::thread> threads;
+    std::thread thread;
+#if FEATURE_MC_SERVICES_COROUTINE
+    // spawned but not yet finished
+    std::atomic<std::size_t> coroutines {0};
+#endif
+    // retained past join(), for diagnostics
+    std::thread::id threadId_;
+
+    void wakeupAdded(time_point wakeup)
+    {
+        sleeper.wakeup(wakeup);
+    }
+
+    /// \return true if anything was posted
+    bool drain()
+    {
+        std::vector<task_type> tasks;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            tasks.swap(posted);
+
+            for(Stepper& s : arriving) steppers.push_back(std::move(s));
+            arriving.clear();
+        }
+
+        for(task_type& task : tasks) task();
+
+        return !tasks.empty();
+    }
+
+    /// Steps each cooperative agent which is due, or all of them once stopping
+    /// \param next brought forward to whenever the earliest of them next wants a step
+    /// \param any set if 'next' was touched
+    void step(const stop_token& token, bool& any, time_point& next)
+    {
+        const time_point now = clock_type::now();
+        const bool stopping = token.stop_requested();
+
+        auto earliest = [&](time_point due)
+        {
+            // Only wake() brings these around again
+            if(due == time_point::max()) return;
+
+            if(!any || due < next)
+            {
+                next = due;
+                any = true;
+            }
+        };
+
+        auto done = std::remove_if(steppers.begin(), steppers.end(), [&](Stepper& s)
+        {
+            time_point due = s.due();
+
+            if(!stopping && now < due)
+            {
+                earliest(due);
+                return false;
+            }
+
+            if(!s.step(token)) return true;
+
+            earliest(s.due());
+            return false;
+        });
+
+        steppers.erase(done, steppers.end());
+    }
+
+    void worker(
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+            stop_token token,
+#else
+            const stop_token& token,
+#endif
+            ThreadAttributes attributes)
+    {
+        applyThreadAttributes(attributes);
+
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        stop_callback stopCallback(token, [this] { wake(); });
+#else
+        // DEBT: Without stop_callback, stop isn't noticed until next wakeup or post()
+#endif
+
+        status(Status::Running);
+
+        while(!token.stop_requested())
+        {
+            drain();
+            scheduler_.run(clock_type::now());
+
+            time_point next;
+            bool any = scheduler_.next_wakeup(next);
+
+            step(token, any, next);
+
+            // Some cooperative agent wants another step already
+            if(any && !(next > clock_type::now())) continue;
+
+            sleeper.sleep(any, next);
+        }
+
+        status(Status::Stopping);
+
+        // One last pass so that cooperative agents get to tear down on our thread
+        drain();
+        {
+            time_point next;
+            bool any = false;
+
+            step(token, any, next);
+        }
+
+#if FEATURE_MC_SERVICES_COROUTINE
+        // Coroutines woken by the stop request may still be on their way, since
+        // request_stop() wakes them one at a time, so wait for them all to wind down.
+        // NOTE: Every coro awaitable wakes on stop.  A foreign one which doesn't holds this up
+        while(coroutines > 0)
+            if(!drain()) sleeper.sleep(false, time_point{});
+#endif
+
+        status(Status::Stopped);
+    }
+
+public:
+    CooperativeExecutor(EnttHelper eh,
+                        duration_type resolution = internal::SchedulerTraits<duration_type>::resolution()) :
+        Agent(eh),
+        scheduler_(resolution, time_point{})
+    {
+        scheduler_.sinkWakeup.template connect<&this_type::wakeupAdded>(*this);
+    }
+
+    /// NOTE: Be sure to request stop beforehand
+    ~CooperativeExecutor()
+    {
+        join();
+    }
+
+    scheduler_type& scheduler() { return scheduler_; }
+
+    /// Number of dedicated threads handed out so far
+    std::size_t threadCount() const { return threads.size(); }
+
+    /// Runs 'task' once on executor thread.  Thread safe
+    void post(task_type task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            posted.push_back(std::move(task));
+        }
+        arrived();
+        wake();
+    }
+
+#if FEATURE_MC_SERVICES_COROUTINE
+    void post(std::coroutine_handle<> h) override
+    {
+        post(task_type([h] { h.resume(); }));
+    }
+
+    scheduler_type& timers() override { return scheduler_; }
+
+    void finished() override
+    {
+        --coroutines;
+    }
+
+    /// Begins coroutine 'agent' on executor thread.  Thread safe
+    template <class TService>
+    void spawn(agents::Coroutine<TService, TClock>& agent, const stop_token& token)
+    {
+        ++coroutines;
+        agent.start(*this, token);
+    }
+#endif
+
+    /// Add periodic 'agent' to run 'delay' from now, on executor thread
+    handle_type add(periodic_type* agent, duration_type delay = duration_type::zero(),
+                    typename scheduler_type::priorities priority = scheduler_type::priorities::idle)
+    {
+        time_point now = clock_type::now();
+        return scheduler_.add(agent, now + delay, now, priority);
+    }
+
+    /// Places 'agent' per its 'threaded' trait, decided at compile time.  Threaded agents
+    /// start right away on their own thread, the rest are stepped on ours whenever their
+    /// due() comes around, if they have one.  Thread safe
+    /// \tparam TAgent SingleShot, CooperativeWorker, StandaloneStdThread or anything else
+    /// exposing 'threaded' alongside run(stop_token) or step(stop_token) to match
+    template <class TAgent>
+    void place(TAgent& agent, const stop_token& token)
+    {
+        if constexpr (TAgent::threaded)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.push_back(agent.run(token));
+        }
+        else
+        {
+            internal::step_waker(agent, [this] { wake(); }, 0);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                arriving.push_back(Stepper{
+                    [&agent](const stop_token& t) { return agent.step(t); },
+                    [&agent] { return internal::step_due<TClock>(agent, 0); }
+                });
+            }
+            wake();
+        }
+    }
+
+    /// Nudge executor thread to re-evaluate
+    void wake()
+    {
+        sleeper.wake();
+    }
+
+    /// Thread which cooperative agents run on
+    std::thread::id threadId() const { return threadId_; }
+
+    /// Starts executor thread
+    void run(const stop_token& token)
+    {
+        status(Status::Starting);
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        thread = std::thread(&this_type::worker, this, token, threadAttributes());
+#else
+        thread = std::thread(&this_type::worker, this, std::ref(token), threadAttributes());
+#endif
+        threadId_ = thread.get_id();
+    }
+
+    /// Blocks until executor thread and all dedicated threads exit
+    void join()
+    {
+        if(thread.joinable()) thread.join();
+
+        for(std::thread& t : threads)
+            if(t.joinable()) t.join();
+    }
+};
+
+}}}
@@ -2,6 +2,22 @@
 
 #include "../../../services.h"
 #include "../../../agents.hpp"
+#include "scheduler.hpp"
+#include "event_bus.hpp"
+#include "executor.hpp"
+#include "reactor.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 // DEBT: Need to be gentler about this, even though I personally won't be using the global
 // min macro others might
@@ -16,23 +32,19 @@ class StdThreadServiceToken :
 {
     typedef ServiceSignalingStopToken base_type;
 protected:
-    std::thread worker;
+    // Owned by the manager, so that it may join it come shutdown
+    std::thread& worker;
 
-    StdThreadServiceToken(const stop_token& stopToken) :
-        base_type(stopToken)
+    StdThreadServiceToken(const stop_token& stopToken, std::thread& worker) :
+        base_type(stopToken),
+        worker(worker)
     {}
 
     StdThreadServiceToken(StdThreadServiceToken&& moveFrom) :
         base_type(moveFrom.stopToken),
-        worker(std::move(moveFrom.worker))
+        worker(moveFrom.worker)
     {
     }
-
-    ~StdThreadServiceToken()
-    {
-        if(worker.joinable())
-            worker.detach();
-    }
 };
 
 // TAgent must be a StandaloneStdThread
@@ -44,8 +56,8 @@ class SpecializedServiceToken : public StdThreadServiceToken
 public:
     typedef TAgent agent_type;
 
-    SpecializedServiceToken(const stop_token& stopToken, TAgent& agent) :
-        StdThreadServiceToken(stopToken),
+    SpecializedServiceToken(const stop_token& stopToken, std::thread& worker, TAgent& agent) :
+        StdThreadServiceToken(stopToken, worker),
         agent_(agent)
     {
 
@@ -98,31 +110,30 @@ public:
 
 
 template <class TAgent, class ...TArgs>
-class EventTokenExp : public ServiceToken
+class EventTokenExp final : public ServiceToken
 {
     TAgent agent_;
 
+public:
+    typedef TAgent agent_type;
     typedef typename TAgent::service_type service_type;
+
+private:
     typedef std::tuple<TArgs...> event_args;
 
     event_args args_;
 
     inline void checkStatusAndStop()
     {
-        Status status = agent_.status();
-
-        if(status != Status::Stopping &&
-            status != Status::Stopped)
-        {
-            agent_.destruct();
-        }
+        if(constructed()) agent_.destruct();
     }
 
 public:
     // DEBT: args ignored at this time
-    EventTokenExp(moducom::services::agents::EnttHelper eh, TArgs&&...args) :
+    template <class ...TArgs2>
+    EventTokenExp(moducom::services::agents::EnttHelper eh, TArgs2&&...args) :
             agent_(eh),
-            args_(std::forward<TArgs>(args)...)
+            args_(std::forward<TArgs2>(args)...)
     {
 
     }
@@ -146,24 +157,207 @@ public:
     {
         checkStatusAndStop();
     }
+
+    agent_type& agent() { return agent_; }
+
+    /// Whether service is in place, i.e. start() succeeded and stop() has yet to be called
+    bool constructed() const
+    {
+        Status status = agent_.status();
+
+        return status == Status::Started || is_running(status);
+    }
+
+    /// Constructs service alone, leaving agent status for caller to bring along.  Distinct
+    /// tokens may do so concurrently when service_type::parallelConstruction() allows
+    void constructService()
+    {
+        std::apply([&](const TArgs&... args)
+                   {
+                       static_cast<agents::Container<service_type>&>(agent_).construct(args...);
+                   }, args_);
+    }
+};
+
+
+/// By-value, contiguous storage for one type of EventTokenExp.  Lives in the EventManager's
+/// registry context
+template <class TToken>
+struct TokenPool : moducom::internal::ChunkedPool<TToken>
+{
+    /// Owning entity, indexed by slot
+    std::vector<entt::entity> entities;
 };
 
 }
 
-class StandaloneStdThreadManager : public agents::Aggregator
+/// How each agent fared in StandaloneStdThreadManager::stop
+enum class Shutdown
 {
-    stop_source stopSource;
-    typedef agents::Aggregator base_type;
+    Stopped,        ///< stopped (or never started) and its thread joined
+    TimedOut,       ///< still running at deadline.  Thread kept, so stop() may be tried again
+    Detached,       ///< still running at deadline, and let go of.  Agent is leaked
+    Failed          ///< service threw and was left down, and its thread joined
+};
 
-    std::vector<agent_type*> _agents() const
+/// How StandaloneStdThreadManager responds to a service whose run() throws
+/// @details Modelled after Erlang/OTP supervisors.  Restarts happen on the failed agent's own
+/// thread, into its own storage, so peers aren't disturbed unless asked for
+struct Supervision
+{
+    enum class Strategy
     {
-        // DEBT: dual dependsOn, need to fix that
-        return agents::Depender::dependsOn();
-    }
+        None,           ///< leave it down, in Status::Error
+        OneForOne,      ///< restart just the one which failed
+        OneForAll       ///< restart it, and every running peer along with it
+    };
+
+    Strategy strategy = Strategy::None;
+    /// More than this many restarts within 'period', across all agents, and the failed
+    /// one is left down
+    unsigned intensity = 3;
+    std::chrono::milliseconds period {5000};
+    /// First restart holds off this long, doubling for each restart still within 'period'
+    std::chrono::milliseconds backoff {1};
+    std::chrono::milliseconds maxBackoff {1000};
+};
+
+
+class StandaloneStdThreadManager :
+    public agents::Aggregator,
+    public agents::Supervisor
+{
+    typedef agents::Aggregator base_type;
 
 public:
     typedef agents::Aggregator::agent_type agent_type;
+    typedef std::chrono::steady_clock clock_type;
+
+    struct ShutdownReport
+    {
+        clock_type::duration duration;
+        std::vector<std::pair<agent_type*, Shutdown> > agents;
+
+        /// \return how many agents fared as 'result'
+        std::size_t count(Shutdown result) const
+        {
+            return std::count_if(agents.begin(), agents.end(),
+                [&](const std::pair<agent_type*, Shutdown>& a) { return a.second == result; });
+        }
+    };
 
+    struct StatisticsReport
+    {
+        /// Sum across every agent
+        agents::WorkerStatistics total;
+        std::vector<std::pair<agent_type*, agents::WorkerStatistics> > agents;
+    };
+
+private:
+    struct Worker
+    {
+        agent_type* agent;
+        // Agent has no virtual destructor, so remember how to delete it as what it really is
+        void (*destroy)(agent_type*);
+        // Likewise, so as to reach where its service lives
+        NumaPlacement (*placement)(agent_type*);
+        void (*restart)(agent_type*);
+        agents::WorkerStatistics (*statistics)(agent_type*);
+        std::thread thread;
+        // Agent reported Stopped, so its thread is on its way out
+        bool done = false;
+        bool detached = false;
+    };
+
+    std::mutex mutex;
+    std::condition_variable workerDone;
+    // std::list, since tokens refer to threads in here
+    std::list<Worker> workers;
+
+    // Kept apart from 'mutex', which stop() holds while joining
+    std::mutex supervisionMutex;
+    Supervision supervision_;
+    // Restarts still within supervision_.period, oldest first
+    std::deque<clock_type::time_point> recentRestarts;
+    std::size_t restarts_ = 0;
+
+    void workerStatus(Agent* agent, Status status)
+    {
+        if(status != Status::Stopped && status != Status::Starting && status != Status::Error)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for(Worker& w : workers)
+                if(w.agent == agent) w.done = status != Status::Starting;
+        }
+
+        workerDone.notify_all();
+    }
+
+    template <class TAgent>
+    Worker& track(TAgent* agent)
+    {
+        base_type::add(*agent);
+        agent->statusSink.template connect<&StandaloneStdThreadManager::workerStatus>(*this);
+        agent->supervisor(this);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        workers.push_back(Worker{agent,
+            [](agent_type* a) { delete static_cast<TAgent*>(a); },
+            [](agent_type* a) { return static_cast<TAgent*>(a)->placement(); },
+            [](agent_type* a) { static_cast<TAgent*>(a)->restart(); },
+            [](agent_type* a) { return static_cast<TAgent*>(a)->statistics(); },
+            std::thread()});
+        return workers.back();
+    }
+
+    bool running(const Worker& w) const
+    {
+        return w.thread.joinable() && !w.done;
+    }
+
+    /// Applies supervision_ to 'agent', on its own thread
+    duration_type failed(Agent& agent, std::exception_ptr) override
+    {
+        const clock_type::time_point now = clock_type::now();
+        duration_type delay;
+        Supervision::Strategy strategy;
+
+        {
+            std::lock_guard<std::mutex> lock(supervisionMutex);
+
+            strategy = supervision_.strategy;
+
+            if(strategy == Supervision::Strategy::None) return duration_type::max();
+
+            while(!recentRestarts.empty() && recentRestarts.front() < now - supervision_.period)
+                recentRestarts.pop_front();
+
+            if(recentRestarts.size() >= supervision_.intensity) return duration_type::max();
+
+            // Shift capped well short of overflow, maxBackoff takes over long before then
+            delay = std::min<duration_type>(
+                supervision_.backoff * (1LL << std::min<std::size_t>(recentRestarts.size(), 20)),
+                supervision_.maxBackoff);
+
+            recentRestarts.push_back(now);
+            ++restarts_;
+        }
+
+        if(strategy == Supervision::Strategy::OneForAll)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for(Worker& w : workers)
+                if(w.agent != &agent && running(w)) w.restart(w.agent);
+        }
+
+        return delay;
+    }
+
+public:
     /// Creates a new service of type TService for this manager to track,
     /// does *not* autostart it
     /// \tparam TService
@@ -175,8 +369,8 @@ public:
         agents::EnttHelper e(entity.registry, entity.registry.create());
         auto agent = new agents::StandaloneStdThread<TService, TArgs...>(e,
                 std::forward<TArgs&&>(args)...);
-        base_type::add(*agent);
-        internal::SpecializedServiceToken<decltype(*agent)> serviceToken(stopSource.token(), *agent);
+        Worker& w = track(agent);
+        internal::SpecializedServiceToken<decltype(*agent)> serviceToken(stopToken(), w.thread, *agent);
         return serviceToken;
     }
 
@@ -187,45 +381,109 @@ public:
         agents::EnttHelper e(entity.registry, entity.registry.create());
         auto agent = new agents::StandaloneStdThread<TService, TArgs...>(e,
              std::forward<TArgs&&>(args)...);
-        base_type::add(*agent);
-        // TODO: Incomplete, this is going to crash since thread ownership gets tossed
-        // to the wind
-        agent->run(stopSource.token());
+        Worker& w = track(agent);
+        w.thread = agent->run(stopToken());
     }
 
-    /// Be advised, this is a blocking call
-    void stop(std::chrono::milliseconds timeout = std::chrono::milliseconds(2000))
+    /// How to respond to services which throw.  Thread safe, and applies from the next failure
+    void supervise(const Supervision& supervision)
     {
-        using namespace std::chrono_literals;
-        constexpr auto slice = 100ms;
+        std::lock_guard<std::mutex> lock(supervisionMutex);
+        supervision_ = supervision;
+    }
 
-        stopSource.request_stop();
+    /// Restarts performed so far, for diagnostics
+    std::size_t restarts()
+    {
+        std::lock_guard<std::mutex> lock(supervisionMutex);
+        return restarts_;
+    }
 
-        // Might be enough to merely set stop signal
-        for(agent_type* agent : _agents())
+    /// Run loop figures for each agent and all of them together.  Agents never wait on
+    /// us mid loop, so this is fine to poll
+    StatisticsReport statistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        StatisticsReport report;
+
+        for(Worker& w : workers)
         {
-            //agent->stop();
+            agents::WorkerStatistics s = w.statistics(w.agent);
+
+            report.total += s;
+            report.agents.emplace_back(w.agent, s);
         }
 
-        // DEBT: One single slow spinwait isn't too bad, but still not best practice
-        // DEBT: Would be nice to use event/sink instead of recounting every time
-        int stillRunning = 0;
-        do
+        return report;
+    }
+
+    /// Where each agent's thread and service ended up, and how much of the work handed
+    /// to it crossed nodes to get there
+    std::vector<std::pair<agent_type*, NumaPlacement> > placements()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::pair<agent_type*, NumaPlacement> > report;
+
+        for(Worker& w : workers)
+            if(!w.detached) report.emplace_back(w.agent, w.placement(w.agent));
+
+        return report;
+    }
+
+    /// Signals every agent to stop at once, then waits for them all under one deadline
+    /// @details Be advised, this is a blocking call.  Waits on agents' status events rather
+    /// than polling, so returns as soon as the last one reports Stopped, then joins them all.
+    /// Agents of child aggregators are signalled too, but only ours are waited on
+    /// \param timeout overall deadline, not per agent
+    /// \param detach when true, agents still running at deadline are let go of
+    /// \return how each agent fared, and how long it all took
+    ShutdownReport stop(std::chrono::milliseconds timeout = std::chrono::milliseconds(2000),
+                        bool detach = false)
+    {
+        const clock_type::time_point start = clock_type::now();
+
+        requestStop();
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        workerDone.wait_until(lock, start + timeout, [&]
         {
-            std::this_thread::sleep_for(slice);
-            for (agent_type* agent : _agents())
-            {
-                Status status = agent->status();
+            return std::none_of(workers.begin(), workers.end(),
+                [&](const Worker& w) { return running(w); });
+        });
 
-                if(status != Status::Stopped &&
-                    status != Status::Unstarted
-                    )
-                    stillRunning++;
+        ShutdownReport report;
+
+        for(Worker& w : workers)
+        {
+            Shutdown result = Shutdown::Stopped;
+
+            if(w.detached)
+                result = Shutdown::Detached;
+            else if(running(w))
+            {
+                if(detach)
+                {
+                    w.thread.detach();
+                    w.detached = true;
+                    result = Shutdown::Detached;
+                }
+                else
+                    result = Shutdown::TimedOut;
             }
+            // DEBT: Agent reports Stopped just *before* its thread truly ends, so this
+            // may block briefly
+            else if(w.thread.joinable())
+                w.thread.join();
+
+            if(result == Shutdown::Stopped && w.agent->status() == Status::Error)
+                result = Shutdown::Failed;
 
-            timeout -= slice;
+            report.agents.emplace_back(w.agent, result);
         }
-        while(stillRunning > 0 && timeout > slice.zero());
+
+        report.duration = clock_type::now() - start;
+        return report;
     }
 
     StandaloneStdThreadManager(agents::EnttHelper eh) :
@@ -234,140 +492,159 @@ public:
 
     ~StandaloneStdThreadManager()
     {
+        stop(std::chrono::milliseconds(2000), true);
+
         // DEBT: Clear out dependencies -- works, but is nonintuitive the way this reads
         base_type::clear();
 
-        for(agent_type* agent : _agents())
+        for(Worker& w : workers)
         {
-            // DEBT: Watch out, since we set 'stopped' just *before* agent thread truly
-            // shuts down, it's possible to hit an invalid state (not a race condition really)
-            // and std::thread may throw an exception of improper shutdown
-            if(agent->status() != Status::Stopped)
-            {
-                // TODO: force agent's thread into detached mode and log an error that
-                // service couldn't shut down properly
-            }
+            w.agent->statusSink.disconnect<&StandaloneStdThreadManager::workerStatus>(*this);
 
-            // NOTE: thread ownership is currently held by SpecializedStartToken, which currently
-            // isn't owned by the agent, but perhaps should be
+            // Its thread is still using it
+            // TODO: log an error that service couldn't shut down properly
+            if(w.detached) continue;
 
-            delete agent;
+            w.destroy(w.agent);
         }
     }
 };
 
-/// Handles both fixed-time and variable-time periodic interval agents
-/// Relies on external mechanism to call this at the right time
-/// TODO: Consider making the whole thing follow the system_clock (and friends)
-/// pattern instead, which includes duration and time_point
-template <class TTimeBase, class TDuration>
-class Scheduler
+class EventManager : public agents::Aggregator
 {
-    // absolute time
-    typedef TTimeBase timebase_type;
-    typedef TDuration duration_type;
-    typedef agents::PeriodicBase<duration_type> agent_type;
+    typedef agents::Aggregator base_type;
 
-    /// lower # = higher priority, service first
-    typedef unsigned short priority_type;
+public:
+    /// Picks which push_exp() entities a bulk start_exp()/stop_exp() applies to
+    typedef std::function<bool (entt::entity)> filter_type;
 
-    enum class priorities : priority_type
-    {
-        highest = 0,
-        high = 100,
-        medium = 200,
-        low = 300,
-        idle = 1000
-    };
+private:
+    // Fewest tokens worth handing another thread during parallel construction
+    static constexpr std::size_t parallelGrain = 64;
 
-    struct Item
+    // One per token type, so that bulk operations make a single indirect call per type
+    // rather than a virtual call per token
+    struct PoolOps
     {
-        timebase_type wakeup;
-        agent_type* agent;
-        priority_type priority;
-
-        bool operator < (const Item& compareTo) const
-        {
-            // remember, since heaps put largest first, and we want smallest first,
-            // we reverse the compare operation
-            return wakeup >= compareTo.wakeup && priority >= compareTo.priority;
-        }
+        std::size_t (*start)(base_type&, const filter_type&);
+        std::size_t (*stop)(base_type&, const filter_type&);
     };
 
-    std::vector<Item> agents;
+    std::vector<PoolOps> pools_;
 
-    Item& first() { return agents.front(); }
-
-    void sort()
+    template <class TToken>
+    static internal::TokenPool<TToken>& tokenPool(base_type& aggregator)
     {
-        std::sort_heap(agents.begin(), agents.end());
+        return *aggregator.registry.try_ctx<internal::TokenPool<TToken> >();
     }
 
-    void pop()
+    template <class TToken>
+    internal::TokenPool<TToken>& tokenPool()
     {
-        std::pop_heap(agents.begin(), agents.end());
-        agents.pop_back();
+        auto pool = registry.try_ctx<internal::TokenPool<TToken> >();
+
+        if(pool != nullptr) return *pool;
+
+        pools_.push_back(PoolOps{&startPool<TToken>, &stopPool<TToken>});
+        return registry.set<internal::TokenPool<TToken> >();
     }
 
-public:
-    Scheduler()
+    template <class TToken>
+    static std::size_t startPool(base_type& aggregator, const filter_type& filter)
     {
-        //std::make_heap(agents.begin(), agents.end());
-    }
+        typedef typename TToken::service_type service_type;
+        typedef typename internal::TokenPool<TToken>::size_type size_type;
 
-    const Item& cfirst() const { return agents.front(); }
+        internal::TokenPool<TToken>& pool = tokenPool<TToken>(aggregator);
+        std::vector<TToken*> tokens;
 
-    size_t count() const noexcept { return agents.size(); }
+        pool.each([&](size_type slot, TToken& token)
+        {
+            if(!token.constructed() && (!filter || filter(pool.entities[slot])))
+                tokens.push_back(&token);
+        });
 
-    void add(agent_type* agent, timebase_type initial_wakeup)
-    {
-        Item item {initial_wakeup, agent,
-                   (priority_type) priorities::idle};
-        agents.emplace_back(item);
-        std::push_heap(agents.begin(), agents.end());
-    }
+        // Status goes through the registry, which isn't thread safe, so only construction
+        // itself fans out
+        for(TToken* token : tokens) token->agent().status(Status::Starting);
 
-    void _run(Item& first, duration_type passed)
-    {
-        // FIX: Not passing in right 'passed' interval just yet
-        duration_type wakeup_interval = first.agent->run(passed);
-        if(wakeup_interval == duration_type::min())
+        std::vector<std::exception_ptr> failures(tokens.size());
+
+        auto construct = [&](std::size_t begin, std::size_t end)
         {
-            // This signals a removal
-            pop();
-            return;
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                try
+                {
+                    tokens[i]->constructService();
+                }
+                catch(...)
+                {
+                    failures[i] = std::current_exception();
+                }
+            }
+        };
+
+        if constexpr (service_type::parallelConstruction())
+        {
+            std::size_t threads = std::min<std::size_t>(
+                std::max(1U, std::thread::hardware_concurrency()),
+                (tokens.size() + parallelGrain - 1) / parallelGrain);
+            std::size_t per = threads > 0 ? (tokens.size() + threads - 1) / threads : 0;
+            std::vector<std::future<void> > helpers;
+
+            for(std::size_t t = 1; t < threads; ++t)
+                helpers.push_back(std::async(std::launch::async, construct,
+                    t * per, std::min(tokens.size(), (t + 1) * per)));
+
+            construct(0, std::min(tokens.size(), per));
+
+            for(std::future<void>& f : helpers) f.get();
         }
-        first.wakeup += wakeup_interval;
-        // put 'first' at the end
-        std::pop_heap(agents.begin(), agents.end());
-        // do heap magic to place next 'lowest' (largest technically by std::heap
-        // definitions) at first
-        std::push_heap(agents.begin(), agents.end());
-    }
+        else
+            construct(0, tokens.size());
 
-    ///
-    /// \param absolute
-    /// \return true when item serviced
-    bool run(timebase_type absolute)
-    {
-        Item& first = this->first();
+        std::size_t started = 0;
 
-        if(absolute >= first.wakeup)
+        for(std::size_t i = 0; i < tokens.size(); ++i)
         {
-            duration_type delta = absolute - first.wakeup;
-            // FIX: delta is not right here, it has to be delta + past requested
-            // interval for 'passed' to be correct
-            _run(first, delta);
-            return true;
+            auto& agent = tokens[i]->agent();
+
+            if(failures[i])
+            {
+                agent.error(agents::internal::describe(failures[i]), "construct");
+                agent.status(Status::Error);
+                continue;
+            }
+
+            agent.status(Status::Started);
+            agent.status(Status::Waiting);
+            ++started;
         }
 
-        return false;
+        return started;
     }
-};
 
-class EventManager : public agents::Aggregator
-{
-    typedef agents::Aggregator base_type;
+    template <class TToken>
+    static std::size_t stopPool(base_type& aggregator, const filter_type& filter)
+    {
+        typedef typename internal::TokenPool<TToken>::size_type size_type;
+
+        internal::TokenPool<TToken>& pool = tokenPool<TToken>(aggregator);
+        std::size_t stopped = 0;
+
+        pool.each([&](size_type slot, TToken& token)
+        {
+            if(token.constructed() && (!filter || filter(pool.entities[slot])))
+            {
+                // Final, so no virtual dispatch
+                token.stop();
+                ++stopped;
+            }
+        });
+
+        return stopped;
+    }
 
 public:
     EventManager(EnttHelper eh) : base_type(eh)
@@ -388,19 +665,54 @@ public:
 
     // experimenting with holding on to token in registry, and having token actually
     // be container for agent as well
+    /// Tokens live contiguously by type, owned by us.  Their entities carry a ServiceToken*
+    /// \return token, stable until we go away
     template <class TService, class ...TArgs>
     auto push_exp(TArgs&&...args)
     {
         agents::EnttHelper e(entity.registry, entity.registry.create());
         typedef agents::Event<TService> agent_type;
+        // Decayed, since start may come long after caller's arguments are gone
+        typedef internal::EventTokenExp<agent_type, std::decay_t<TArgs>...> token_type;
         //auto agent = new agent_type(e, std::forward<TArgs>(args)...);
         //base_type::add(*agent);
-        auto* serviceToken = new internal::EventTokenExp<agent_type, TArgs...>(
-                e, std::forward<TArgs>(args)...);
-        e.registry.emplace<std::unique_ptr<ServiceToken> >(e.entity, serviceToken);
+        internal::TokenPool<token_type>& pool = tokenPool<token_type>();
+        std::size_t slot = pool.emplace(e, std::forward<TArgs>(args)...);
+        token_type* serviceToken = &pool[slot];
+
+        if(pool.entities.size() <= slot)
+            pool.entities.resize(slot + 1, entt::null);
+
+        pool.entities[slot] = e.entity;
+        e.registry.emplace<ServiceToken*>(e.entity, serviceToken);
         return serviceToken;
     }
 
+    /// Starts, in one go, every push_exp() token not already started whose entity passes
+    /// 'filter', i.e. [&](entt::entity e) { return view.contains(e); }
+    /// @details Services whose parallelConstruction() is true are constructed across
+    /// several threads.  A service whose constructor throws is left in Status::Error
+    /// \return how many started
+    std::size_t start_exp(const filter_type& filter = filter_type())
+    {
+        std::size_t started = 0;
+
+        for(const PoolOps& ops : pools_) started += ops.start(*this, filter);
+
+        return started;
+    }
+
+    /// Stops, in one go, every started push_exp() token whose entity passes 'filter'
+    /// \return how many stopped
+    std::size_t stop_exp(const filter_type& filter = filter_type())
+    {
+        std::size_t stopped = 0;
+
+        for(const PoolOps& ops : pools_) stopped += ops.stop(*this, filter);
+
+        return stopped;
+    }
+
 
     void stop()
     {
@@ -0,0 +1,304 @@
+/**
+ * @file
+ * @brief Reactor agent, dispatching file descriptor readiness on one shared thread
+ * @details Built on epoll plus an eventfd, so a stop request (or anything posted) wakes the
+ *          loop at once rather than on its next timeout.  Linux only, and compiled out elsewhere
+ */
+#pragma once
+
+#include "agent.h"
+
+#ifndef FEATURE_MC_SERVICES_REACTOR
+#if __linux__
+#define FEATURE_MC_SERVICES_REACTOR 1
+#else
+#define FEATURE_MC_SERVICES_REACTOR 0
+#endif
+#endif
+
+#if FEATURE_MC_SERVICES_REACTOR
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "../stop_token.h"
+
+namespace moducom { namespace services { namespace managers {
+
+/// Waits on many services' file descriptors at once, calling each one's handler as it
+/// becomes ready
+/// @details Handlers run on the reactor thread one at a time, so services sharing it need no
+/// locking among themselves, but must not block.  Readiness is level triggered unless
+/// 'edge' is part of the requested events
+class Reactor : public Agent
+{
+public:
+    /// Called with whichever events fired, i.e. readable | hangup
+    typedef std::function<void (unsigned)> handler_type;
+    typedef std::function<void ()> task_type;
+
+    static constexpr unsigned readable = EPOLLIN;
+    static constexpr unsigned writable = EPOLLOUT;
+    static constexpr unsigned hangup = EPOLLHUP | EPOLLRDHUP;
+    static constexpr unsigned fault = EPOLLERR;
+    static constexpr unsigned edge = EPOLLET;
+
+private:
+    typedef Reactor this_type;
+
+    // Most events handled per epoll_wait
+    static constexpr int batch = 64;
+
+    const int epollFd;
+    const int wakeFd;
+
+    std::mutex mutex;
+    // shared_ptr so that a handler removed mid dispatch lives out its call
+    std::unordered_map<int, std::shared_ptr<handler_type> > handlers;
+    std::vector<task_type> posted;
+
+    // Held by reactor thread across each batch of handlers, so that remove() from
+    // elsewhere can wait one out
+    std::mutex dispatching;
+
+    std::thread thread;
+    std::atomic<std::thread::id> threadId_;
+
+    static int check(int result, const char* what)
+    {
+        if(result < 0) throw std::system_error(errno, std::generic_category(), what);
+        return result;
+    }
+
+    void ctl(int op, int fd, unsigned events)
+    {
+        epoll_event e {};
+
+        e.events = events;
+        e.data.fd = fd;
+
+        check(epoll_ctl(epollFd, op, fd, &e), "reactor: epoll_ctl");
+    }
+
+    void drain()
+    {
+        std::uint64_t count;
+        std::vector<task_type> tasks;
+
+        // Nonblocking, so at most one spurious EAGAIN
+        ssize_t r = read(wakeFd, &count, sizeof(count));
+        (void)r;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.swap(posted);
+        }
+
+        for(task_type& task : tasks) task();
+    }
+
+    void dispatch(int fd, unsigned events)
+    {
+        std::shared_ptr<handler_type> handler;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            auto i = handlers.find(fd);
+
+            // Removed since epoll_wait returned, perhaps by an earlier handler in this batch
+            if(i == handlers.end()) return;
+
+            handler = i->second;
+        }
+
+        (*handler)(events);
+    }
+
+    void worker(
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+            stop_token token,
+#else
+            const stop_token& token,
+#endif
+            ThreadAttributes attributes)
+    {
+        threadId_ = std::this_thread::get_id();
+
+        applyThreadAttributes(attributes);
+
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        stop_callback stopCallback(token, [this] { wake(); });
+#else
+        // DEBT: Without stop_callback, stop isn't noticed until next event or timer
+#endif
+
+        status(Status::Running);
+
+        std::array<epoll_event, batch> events;
+
+        while(!token.stop_requested())
+        {
+            int n = epoll_wait(epollFd, events.data(), batch, -1);
+
+            if(n < 0)
+            {
+                if(errno == EINTR) continue;
+
+                error("epoll_wait: " + std::generic_category().message(errno), "reactor");
+                status(Status::Error);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(dispatching);
+
+            for(int i = 0; i < n; ++i)
+            {
+                if(events[i].data.fd == wakeFd)
+                    drain();
+                else
+                    dispatch(events[i].data.fd, events[i].events);
+            }
+        }
+
+        status(Status::Stopping);
+
+        // Anything posted on the way down still gets its turn on our thread
+        drain();
+
+        status(Status::Stopped);
+    }
+
+public:
+    /// \throws std::system_error if epoll or eventfd can't be had
+    Reactor(EnttHelper eh) :
+        Agent(eh),
+        epollFd(check(epoll_create1(EPOLL_CLOEXEC), "reactor: epoll_create1")),
+        wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    {
+        if(wakeFd < 0)
+        {
+            int code = errno;
+            close(epollFd);
+            throw std::system_error(code, std::generic_category(), "reactor: eventfd");
+        }
+
+        ctl(EPOLL_CTL_ADD, wakeFd, readable);
+    }
+
+    Reactor(const Reactor&) = delete;
+
+    /// NOTE: Be sure to request stop beforehand
+    ~Reactor()
+    {
+        join();
+
+        close(wakeFd);
+        close(epollFd);
+    }
+
+    /// Calls 'handler' on reactor thread whenever 'fd' is ready for any of 'events'.  Thread safe
+    /// @details Be sure to remove() before closing 'fd'
+    /// \throws std::system_error if epoll refuses 'fd', i.e. already added or not pollable
+    void add(int fd, unsigned events, handler_type handler)
+    {
+        auto h = std::make_shared<handler_type>(std::move(handler));
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        ctl(EPOLL_CTL_ADD, fd, events);
+        handlers.emplace(fd, std::move(h));
+    }
+
+    /// Changes which events 'fd' is waited on for.  Thread safe
+    void modify(int fd, unsigned events)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        ctl(EPOLL_CTL_MOD, fd, events);
+    }
+
+    /// Stops waiting on 'fd'.  Thread safe
+    /// @details Once this returns its handler is no longer running, nor will it be called
+    /// again.  From within a handler, the one in progress is of course left to finish
+    void remove(int fd)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(handlers.erase(fd) == 0) return;
+
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+
+        if(std::this_thread::get_id() != threadId_.load())
+            std::lock_guard<std::mutex> wait(dispatching);
+    }
+
+    /// Number of file descriptors being waited on
+    std::size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return handlers.size();
+    }
+
+    /// Runs 'task' once on reactor thread.  Thread safe
+    void post(task_type task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            posted.push_back(std::move(task));
+        }
+        arrived();
+        wake();
+    }
+
+    /// Nudge reactor thread out of its wait.  Thread safe, and safe from signal handlers
+    void wake()
+    {
+        std::uint64_t one = 1;
+
+        ssize_t r = write(wakeFd, &one, sizeof(one));
+        (void)r;
+    }
+
+    /// Thread which handlers run on
+    std::thread::id threadId() const { return threadId_; }
+
+    /// Starts reactor thread
+    void run(const stop_token& token)
+    {
+        status(Status::Starting);
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        thread = std::thread(&this_type::worker, this, token, threadAttributes());
+#else
+        thread = std::thread(&this_type::worker, this, std::ref(token), threadAttributes());
+#endif
+        threadId_ = thread.get_id();
+    }
+
+    /// Blocks until reactor thread exits
+    void join()
+    {
+        if(thread.joinable()) thread.join();
+    }
+};
+
+}}}
+
+#endif
@@ -0,0 +1,1053 @@
+#pragma once
+
+#include "../../../services.h"
+#include "../../../agents.hpp"
+
+#include "../internal/histogram.h"
+#include "../internal/sleeper.h"
+#include "../internal/timer_wheel.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Per-agent lateness and runtime histograms, kept beside the wheel rather than in it.
+// Costs two steady_clock reads per run
+#ifndef FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+#define FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM 1
+#endif
+
+// DEBT: Need to be gentler about this, even though I personally won't be using the global
+// min macro others might
+#undef min
+
+namespace moducom { namespace services { namespace managers {
+
+namespace internal {
+
+/// Describes how a duration maps onto integral scheduler ticks
+/// @details Primary template assumes one tick per unit of TDuration, and that
+/// TDuration / TDuration yields an integral count which TDuration may be multiplied by
+template <class TDuration>
+struct SchedulerTraits
+{
+    typedef TDuration duration_type;
+
+    static duration_type resolution() { return duration_type(1); }
+
+    /// Lateness which earns a due item one priority band
+    static duration_type aging() { return duration_type(100); }
+};
+
+template <class Rep, class Period>
+struct SchedulerTraits<std::chrono::duration<Rep, Period> >
+{
+    typedef std::chrono::duration<Rep, Period> duration_type;
+
+    /// 1ms, or one unit of duration_type if that is coarser
+    static duration_type resolution()
+    {
+        duration_type r = std::chrono::ceil<duration_type>(std::chrono::milliseconds(1));
+        return r > duration_type(1) ? r : duration_type(1);
+    }
+
+    static duration_type aging()
+    {
+        return std::chrono::ceil<duration_type>(std::chrono::milliseconds(100));
+    }
+};
+
+}
+
+/// Handles both fixed-time and variable-time periodic interval agents
+/// Relies on external mechanism to call this at the right time
+/// @details Backed by a hierarchical timing wheel, so add, removal and expiry are all O(1).
+/// Wakeups are filed under ticks of 'resolution' but expire with full TTimeBase precision
+/// TODO: Consider making the whole thing follow the system_clock (and friends)
+/// pattern instead, which includes duration and time_point
+template <class TTimeBase, class TDuration>
+class Scheduler
+{
+public:
+    // absolute time
+    typedef TTimeBase timebase_type;
+    typedef TDuration duration_type;
+    typedef agents::PeriodicBase<duration_type> agent_type;
+
+    /// lower # = higher priority, service first
+    typedef unsigned short priority_type;
+
+    /// Values in between these are fine too, and are reported under the band beneath them
+    enum class priorities : priority_type
+    {
+        highest = 0,
+        high = 100,
+        medium = 200,
+        low = 300,
+        idle = 1000
+    };
+
+    static constexpr unsigned priority_bands = 5;
+
+    /// \return 0 (highest) through 4 (idle)
+    static constexpr unsigned band(priority_type p)
+    {
+        return p >= (priority_type) priorities::idle ? 4 :
+               p >= (priority_type) priorities::low ? 3 :
+               p / (priority_type) priorities::high;
+    }
+
+    typedef moducom::internal::Log2Histogram<> histogram_type;
+
+    struct AgentStatistics
+    {
+        /// in ticks of 'resolution'
+        histogram_type lateness;
+        /// in nanoseconds, per steady_clock regardless of TTimeBase
+        histogram_type runtime;
+    };
+
+    struct Item
+    {
+        timebase_type wakeup;
+        agent_type* agent;
+        priority_type priority;
+        /// when agent last ran, or when it was added if it hasn't yet
+        timebase_type previous;
+        /// as last returned by agent, zero until it first runs
+        duration_type interval;
+        // While due or running, the item is out of the wheel and whoever holds it
+        // acts on these once it's done
+        bool cancelled = false;
+        bool moved = false;
+        // Last wakeup was skipped per CatchUp::Skip, so this one runs however late
+        bool skipped = false;
+    };
+
+private:
+    typedef moducom::internal::TimerWheel<Item> wheel_type;
+    typedef typename wheel_type::index_type index_type;
+    typedef typename wheel_type::tick_type tick_type;
+    typedef typename wheel_type::generation_type generation_type;
+
+public:
+    /// Refers to one scheduled agent, for cancelling or moving it from outside
+    /// @details Goes stale once the agent is cancelled or removes itself, after which
+    /// operations on it do nothing and return false.  Cheap to copy, safe to use from
+    /// any thread but must not outlive its Scheduler
+    class Handle
+    {
+        friend class Scheduler;
+
+        Scheduler* scheduler_ = nullptr;
+        index_type index;
+        generation_type generation;
+
+        Handle(Scheduler* scheduler, index_type index, generation_type generation) :
+            scheduler_(scheduler), index(index), generation(generation) {}
+
+    public:
+        Handle() = default;
+
+        Scheduler* scheduler() const { return scheduler_; }
+
+        /// \return true while the agent remains scheduled
+        bool pending() const
+        {
+            return scheduler_ != nullptr && scheduler_->pending(*this);
+        }
+
+        /// Removes the agent.  If it is running right now, it finishes first
+        /// \return false if already gone
+        bool cancel() const
+        {
+            return scheduler_ != nullptr && scheduler_->cancel(*this);
+        }
+
+        /// Moves the agent's next run to 'wakeup', earlier or later.  If it is running
+        /// right now, this replaces whatever interval that run returns
+        /// \return false if already gone
+        bool reschedule(timebase_type wakeup) const
+        {
+            return scheduler_ != nullptr && scheduler_->reschedule(*this, wakeup);
+        }
+    };
+
+    typedef Handle handle_type;
+
+private:
+
+    const timebase_type origin;
+    const duration_type resolution;
+
+    mutable std::mutex mutex;
+    wheel_type wheel;
+
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+    // Indexed like the wheel, but kept out of its nodes so that they stay small
+    std::vector<AgentStatistics> agentStatistics;
+#endif
+
+    entt::sigh<void (timebase_type)> signalWakeup;
+    entt::sigh<void (std::size_t)> signalBacklog;
+    entt::sigh<void (timebase_type)> signalRunning;
+
+    struct Ready
+    {
+        // priority once aged
+        priority_type effective;
+        timebase_type wakeup;
+        index_type i;
+        // 'absolute' as of expiry.  Whoever pops this may be running on an older one
+        timebase_type expired;
+
+        /// heap order, true when 'this' should be serviced after 'rhs'
+        bool operator<(const Ready& rhs) const
+        {
+            if(effective != rhs.effective) return effective > rhs.effective;
+
+            return !(rhs.wakeup >= wakeup);
+        }
+    };
+
+    // Items which are due but not yet serviced, as a heap so that the most urgent comes
+    // out first.  Anyone may pull from this, which is what lets idle threads help out a busy one
+    std::vector<Ready> ready;
+
+    duration_type aging_;
+
+public:
+    struct Statistics
+    {
+        std::size_t runs = 0;
+        duration_type lateness_total = duration_type::zero();
+        duration_type lateness_max = duration_type::zero();
+    };
+
+private:
+    std::array<Statistics, priority_bands> statistics_;
+
+    tick_type ticks(const timebase_type& t) const
+    {
+        if(origin >= t) return 0;
+
+        return static_cast<tick_type>((t - origin) / resolution);
+    }
+
+    static bool earlier(const Item& lhs, const Item& rhs)
+    {
+        return !(lhs.wakeup >= rhs.wakeup);
+    }
+
+    /// Expects 'lock' to be held on entry, and releases it while the agent itself runs
+    /// \return false if agent was skipped rather than run
+    bool _run(std::unique_lock<std::mutex>& lock, index_type i, timebase_type absolute)
+    {
+        Item& due = wheel[i];
+
+        if(due.cancelled)
+        {
+            wheel.erase(i);
+            return false;
+        }
+
+        if(due.moved)
+        {
+            due.moved = false;
+            wheel.link(i, ticks(due.wakeup));
+            return false;
+        }
+
+        duration_type lateness = absolute - due.wakeup;
+        // Statistics and histogram buckets expect nothing below zero.  Expiry ensures as
+        // much today, but an unsigned bucket index would take anything less very badly
+        if(!(lateness >= duration_type::zero())) lateness = duration_type::zero();
+        duration_type passed = absolute - due.previous;
+        agent_type* agent = due.agent;
+        std::size_t backlog = ready.size();
+
+        // Where the grid resumes for Skip and Coalesce.  Only meaningful when 'missed'
+        bool missed = false;
+        timebase_type aligned = due.wakeup;
+
+        if(agent->catchUp() != agents::CatchUp::Burst &&
+           !(duration_type::zero() >= due.interval) && lateness >= due.interval)
+        {
+            missed = true;
+            // first aligned tick strictly after 'absolute'
+            aligned += due.interval * (lateness / due.interval + 1);
+
+            if(agent->catchUp() == agents::CatchUp::Skip && !due.skipped)
+            {
+                due.skipped = true;
+                due.wakeup = aligned;
+                wheel.link(i, ticks(aligned));
+                return false;
+            }
+        }
+
+        due.skipped = false;
+
+        due.previous = absolute;
+
+        Statistics& stats = statistics_[band(due.priority)];
+
+        ++stats.runs;
+        stats.lateness_total += lateness;
+        if(!(stats.lateness_max >= lateness)) stats.lateness_max = lateness;
+
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+        agentStatistics[i].lateness.add(static_cast<std::uint64_t>(lateness / resolution));
+#endif
+
+        // Only looked up when somebody listens, since it walks the earliest slot
+        index_type next = signalRunning.empty() ? wheel_type::npos : wheel.earliest(earlier);
+        timebase_type next_wakeup = next == wheel_type::npos ? due.wakeup : wheel[next].wakeup;
+
+        lock.unlock();
+
+        if(backlog > 0) signalBacklog.publish(backlog);
+        if(next != wheel_type::npos) signalRunning.publish(next_wakeup);
+
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+        auto started = std::chrono::steady_clock::now();
+#endif
+        duration_type wakeup_interval = agent->run(passed);
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+        auto runtime = std::chrono::steady_clock::now() - started;
+#endif
+        lock.lock();
+
+        // NOTE: Re-acquire item since agent may have added to us, relocating nodes
+        Item& item = wheel[i];
+
+        // min() signals a removal
+        if(wakeup_interval == duration_type::min() || item.cancelled)
+        {
+            wheel.erase(i);
+            return true;
+        }
+
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+        agentStatistics[i].runtime.add(static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(runtime).count()));
+#endif
+
+        // Advance from when we were due rather than from 'absolute', so lateness
+        // never accumulates into drift.  If that is still in the past, next
+        // expiry applies the catch-up policy
+        // A reschedule while running already set 'wakeup'
+        if(item.moved)
+            item.moved = false;
+        else if(missed)
+            item.wakeup = aligned;
+        else
+            item.wakeup += wakeup_interval;
+
+        item.interval = wakeup_interval;
+        wheel.link(i, ticks(item.wakeup));
+        return true;
+    }
+
+    /// Priority of item 'i' once it has been waiting since its wakeup.  Every 'aging_'
+    /// of lateness promotes it by one band, so that low priority items are never
+    /// starved indefinitely by a steady stream of more urgent ones
+    priority_type effective(const Item& item, timebase_type absolute) const
+    {
+        if(duration_type::zero() >= aging_) return item.priority;
+
+        auto steps = (absolute - item.wakeup) / aging_;
+        auto boost = steps * (priority_type) priorities::high;
+
+        return boost >= item.priority ? 0 : priority_type(item.priority - boost);
+    }
+
+    /// Moves everything due at 'absolute' into 'ready'
+    void expire(timebase_type absolute)
+    {
+        wheel.advance(ticks(absolute),
+            [&](index_type i) { return absolute >= wheel[i].wakeup; },
+            [&](index_type i)
+            {
+                const Item& item = wheel[i];
+                ready.push_back(Ready{effective(item, absolute), item.wakeup, i, absolute});
+                std::push_heap(ready.begin(), ready.end());
+            });
+    }
+
+    /// \return most urgent item due, if any
+    std::optional<Ready> pop_ready()
+    {
+        if(ready.empty()) return std::nullopt;
+
+        std::pop_heap(ready.begin(), ready.end());
+        std::optional<Ready> r(ready.back());
+        ready.pop_back();
+        return r;
+    }
+
+    /// Services 'r' as of 'absolute', or as of its expiry if a peer expired it later than that
+    bool _run(std::unique_lock<std::mutex>& lock, const Ready& r, timebase_type absolute)
+    {
+        return _run(lock, r.i, r.expired >= absolute ? r.expired : absolute);
+    }
+
+    /// \return true if 'h' still refers to a scheduled agent.  Expects lock to be held
+    bool _pending(const Handle& h) const
+    {
+        return wheel.allocated(h.index) &&
+               wheel.generation(h.index) == h.generation &&
+               !wheel[h.index].cancelled;
+    }
+
+public:
+    /// \param resolution duration of one wheel tick.  Coarser means fewer cascades, finer
+    /// means less bunching of nearby wakeups into one slot
+    /// \param origin time corresponding to tick 0.  Wakeups prior to this are treated as
+    /// immediately due
+    Scheduler(duration_type resolution = internal::SchedulerTraits<duration_type>::resolution(),
+              timebase_type origin = timebase_type(duration_type::zero())) :
+        origin(origin),
+        resolution(resolution),
+        aging_(internal::SchedulerTraits<duration_type>::aging()),
+        sinkWakeup{signalWakeup},
+        sinkBacklog{signalBacklog},
+        sinkRunning{signalRunning}
+    {
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /// Fires with the new wakeup whenever an item is added from outside of run()
+    entt::sink<void (timebase_type)> sinkWakeup;
+
+    /// Fires with the number of items still waiting whenever one is serviced while
+    /// others which are also due wait behind it
+    entt::sink<void (std::size_t)> sinkBacklog;
+
+    /// Fires just before an agent runs, with the earliest wakeup still waiting in the wheel.
+    /// That is when somebody ought to look in, should the agent overrun.  Silent if the
+    /// wheel is otherwise empty
+    entt::sink<void (timebase_type)> sinkRunning;
+
+    bool pending(const Handle& h) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return _pending(h);
+    }
+
+    /// O(1).  See Handle::cancel
+    bool cancel(const Handle& h)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(!_pending(h)) return false;
+
+        if(wheel.linked(h.index))
+            wheel.erase(h.index);
+        else
+            // due or running, so leave it to whoever holds it
+            wheel[h.index].cancelled = true;
+
+        return true;
+    }
+
+    /// O(1).  See Handle::reschedule
+    bool reschedule(const Handle& h, timebase_type wakeup)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if(!_pending(h)) return false;
+
+            Item& item = wheel[h.index];
+            item.wakeup = wakeup;
+
+            if(wheel.linked(h.index))
+            {
+                wheel.unlink(h.index);
+                wheel.link(h.index, ticks(wakeup));
+            }
+            else
+                item.moved = true;
+        }
+
+        signalWakeup.publish(wakeup);
+        return true;
+    }
+
+    /// Earliest item waiting in the wheel.  Undefined if there is none, which includes when
+    /// every item is due or running
+    /// DEBT: Not thread safe, prefer next_wakeup()
+    const Item& cfirst() const { return wheel[wheel.earliest(earlier)]; }
+
+    size_t count() const noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return wheel.size();
+    }
+
+    /// Number of items due but not yet serviced
+    size_t backlog() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return ready.size();
+    }
+
+    /// Lateness which promotes a waiting item by one priority band.  Zero disables aging,
+    /// leaving due items in strict priority order
+    void aging(duration_type a)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        aging_ = a;
+    }
+
+    /// Totals across all priorities
+    Statistics statistics() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Statistics total = statistics_[0];
+
+        for(unsigned i = 1; i < priority_bands; ++i)
+        {
+            const Statistics& s = statistics_[i];
+
+            total.runs += s.runs;
+            total.lateness_total += s.lateness_total;
+            if(!(total.lateness_max >= s.lateness_max)) total.lateness_max = s.lateness_max;
+        }
+
+        return total;
+    }
+
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+    /// Visits lateness and runtime of every scheduled agent
+    /// \param f void(const agent_type*, const AgentStatistics&), called with lock held
+    template <class F>
+    void each(F&& f) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        wheel.each([&](index_type i, const Item& item)
+        {
+            f(item.agent, agentStatistics[i]);
+        });
+    }
+
+    /// Lateness and runtime of one agent
+    /// DEBT: Linear search, intended for diagnostics rather than anything per-run
+    /// \return false if 'agent' isn't scheduled here
+    bool statistics(const agent_type* agent, AgentStatistics& out) const
+    {
+        bool found = false;
+
+        each([&](const agent_type* a, const AgentStatistics& stats)
+        {
+            if(a == agent)
+            {
+                out = stats;
+                found = true;
+            }
+        });
+
+        return found;
+    }
+#endif
+
+    /// Statistics for items whose priority falls within 'p's band
+    Statistics statistics(priorities p) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return statistics_[band((priority_type) p)];
+    }
+
+    /// \return false if nothing is waiting in the wheel, even if items are due or running
+    bool next_wakeup(timebase_type& wakeup) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        index_type i = wheel.earliest(earlier);
+
+        if(i == wheel_type::npos) return false;
+
+        wakeup = wheel[i].wakeup;
+        return true;
+    }
+
+    /// Thread safe, may be called from any thread including from within an agent's run()
+    /// \param registered 'passed' for the agent's first run is measured from here.  Defaults
+    /// to 'initial_wakeup'
+    /// \param priority decides who goes first among items due at the same time
+    /// \return handle for cancelling or rescheduling this agent later
+    Handle add(agent_type* agent, timebase_type initial_wakeup,
+               priorities priority = priorities::idle)
+    {
+        return add(agent, initial_wakeup, initial_wakeup, priority);
+    }
+
+    Handle add(agent_type* agent, timebase_type initial_wakeup, timebase_type registered,
+               priorities priority = priorities::idle)
+    {
+        Item item {initial_wakeup, agent,
+                   (priority_type) priority,
+                   registered, duration_type::zero()};
+        Handle h;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            index_type i = wheel.insert(ticks(initial_wakeup), item);
+            h = Handle(this, i, wheel.generation(i));
+#if FEATURE_MC_SERVICES_SCHEDULER_HISTOGRAM
+            // Slots are reused, so start this one over
+            if(agentStatistics.size() <= i) agentStatistics.resize(i + 1);
+            agentStatistics[i] = AgentStatistics();
+#endif
+        }
+        signalWakeup.publish(initial_wakeup);
+        return h;
+    }
+
+    ///
+    /// \param absolute
+    /// \return true when one or more items serviced
+    /// @details Services each item due at 'absolute' once, most urgent first.  Items which
+    /// re-schedule themselves at or before 'absolute' are serviced on a subsequent call
+    bool run(timebase_type absolute)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        expire(absolute);
+
+        bool serviced = false;
+
+        // NOTE: Other threads may pull from 'ready' while we're unlocked running an item,
+        // and expire more into it as of a later 'absolute' than ours
+        while(std::optional<Ready> r = pop_ready())
+            if(_run(lock, *r, absolute)) serviced = true;
+
+        return serviced;
+    }
+
+    /// Services one item due at 'absolute'
+    /// @details Intended for threads helping out while this scheduler's own thread is stuck
+    /// in an agent.  Expires the wheel first, so items which came due meanwhile are
+    /// included, not just those already waiting
+    /// \return true when an item was serviced
+    bool run_ready(timebase_type absolute)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        expire(absolute);
+
+        while(std::optional<Ready> r = pop_ready())
+            if(_run(lock, *r, absolute)) return true;
+
+        return false;
+    }
+};
+
+
+namespace internal {
+
+using moducom::internal::Sleeper;
+
+}
+
+
+/// Drives a Scheduler from its own thread
+/// @details Sleeps until precisely the earliest wakeup, or until woken early by a new add()
+/// or a stop request.  Every item due is serviced per wakeup.  Time is kept by TClock, which
+/// should be monotonic
+template <class TClock = std::chrono::steady_clock>
+class SchedulerDriver : public Agent
+{
+public:
+    typedef TClock clock_type;
+    typedef typename clock_type::time_point time_point;
+    typedef typename clock_type::duration duration_type;
+    typedef Scheduler<time_point, duration_type> scheduler_type;
+    typedef agents::PeriodicBase<duration_type> agent_type;
+
+private:
+    typedef SchedulerDriver this_type;
+
+    scheduler_type scheduler_;
+    internal::Sleeper<clock_type> sleeper;
+
+    void wakeupAdded(time_point wakeup)
+    {
+        sleeper.wakeup(wakeup);
+    }
+
+    void worker(
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+            stop_token token,
+#else
+            const stop_token& token,
+#endif
+            ThreadAttributes attributes)
+    {
+        applyThreadAttributes(attributes);
+
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        stop_callback stopCallback(token, [this] { wake(); });
+#else
+        // DEBT: Without stop_callback, stop isn't noticed until next wakeup or add()
+#endif
+
+        status(Status::Running);
+
+        while(!token.stop_requested())
+        {
+            scheduler_.run(clock_type::now());
+
+            time_point next;
+            bool any = scheduler_.next_wakeup(next);
+
+            sleeper.sleep(any, next);
+        }
+
+        status(Status::Stopping);
+        status(Status::Stopped);
+    }
+
+public:
+    SchedulerDriver(EnttHelper eh,
+                    duration_type resolution = internal::SchedulerTraits<duration_type>::resolution()) :
+        Agent(eh),
+        scheduler_(resolution, time_point{})
+    {
+        scheduler_.sinkWakeup.template connect<&this_type::wakeupAdded>(*this);
+    }
+
+    scheduler_type& scheduler() { return scheduler_; }
+
+    typedef typename scheduler_type::priorities priorities;
+
+    typedef typename scheduler_type::handle_type handle_type;
+
+    handle_type add(agent_type* agent, time_point initial_wakeup,
+                    priorities priority = priorities::idle)
+    {
+        return scheduler_.add(agent, initial_wakeup, clock_type::now(), priority);
+    }
+
+    /// Add 'agent' to run 'delay' from now
+    handle_type add(agent_type* agent, duration_type delay = duration_type::zero(),
+                    priorities priority = priorities::idle)
+    {
+        time_point now = clock_type::now();
+        return scheduler_.add(agent, now + delay, now, priority);
+    }
+
+    /// Nudge worker to re-evaluate its wakeup
+    void wake()
+    {
+        sleeper.wake();
+    }
+
+    std::thread run(const stop_token& token)
+    {
+        status(Status::Starting);
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        std::thread thread(&this_type::worker, this, token, threadAttributes());
+#else
+        std::thread thread(&this_type::worker, this, std::ref(token), threadAttributes());
+#endif
+        return thread;
+    }
+};
+
+
+/// Spreads periodic agents across several threads, each with its own Scheduler
+/// @details Agents are placed on whichever shard currently holds the fewest.  While a shard
+/// is stuck in an agent, an idle peer steps in to service whatever else there comes due,
+/// whether already waiting behind it or due only once the overrun began.  Time is kept by
+/// TClock, which should be monotonic
+template <class TClock = std::chrono::steady_clock>
+class ShardedScheduler : public Agent
+{
+public:
+    typedef TClock clock_type;
+    typedef typename clock_type::time_point time_point;
+    typedef typename clock_type::duration duration_type;
+    typedef Scheduler<time_point, duration_type> scheduler_type;
+    typedef agents::PeriodicBase<duration_type> agent_type;
+
+    struct ShardStatistics
+    {
+        std::size_t agents;         ///< currently placed on this shard
+        std::size_t backlog;        ///< due, but not yet serviced
+        std::size_t runs;           ///< serviced, by this shard or its helpers
+        std::size_t stolen;         ///< serviced by this shard on behalf of others
+        duration_type lateness_total;
+        duration_type lateness_max;
+    };
+
+private:
+    typedef ShardedScheduler this_type;
+
+    struct Shard
+    {
+        this_type* const parent;
+        scheduler_type scheduler;
+        internal::Sleeper<clock_type> sleeper;
+        std::atomic<std::size_t> stolen {0};
+        // Within scheduler.run(), so possibly stuck there.  Only then do peers steal
+        std::atomic<bool> busy {false};
+        std::thread thread;
+
+        void wakeupAdded(time_point wakeup)
+        {
+            sleeper.wakeup(wakeup);
+        }
+
+        void backlog(std::size_t)
+        {
+            parent->recruit(this);
+        }
+
+        void running(time_point next)
+        {
+            parent->watch(this, next);
+        }
+
+        Shard(this_type* parent, duration_type resolution) :
+            parent(parent),
+            scheduler(resolution, time_point{})
+        {
+            scheduler.sinkWakeup.template connect<&Shard::wakeupAdded>(*this);
+            scheduler.sinkBacklog.template connect<&Shard::backlog>(*this);
+            scheduler.sinkRunning.template connect<&Shard::running>(*this);
+        }
+    };
+
+    struct WakeAll
+    {
+        this_type* const parent;
+
+        void operator()() const
+        {
+            for(auto& shard : parent->shards) shard->sleeper.wake();
+        }
+    };
+
+    // unique_ptr since Shard can be neither copied nor moved
+    std::vector<std::unique_ptr<Shard> > shards;
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+    std::optional<stop_callback<WakeAll> > stopCallback;
+#endif
+
+    /// Wake one idle shard to help 'busy' with its backlog
+    void recruit(Shard* busy)
+    {
+        for(auto& shard : shards)
+        {
+            if(shard.get() != busy && shard->sleeper.sleeping())
+            {
+                shard->sleeper.wake();
+                return;
+            }
+        }
+    }
+
+    /// Have one idle shard look in on 'busy' at 'next', in case it's still stuck by then
+    /// @details Only disturbs a peer due to sleep past 'next', which then recalculates its
+    /// own wakeup to include 'next'
+    void watch(Shard* busy, time_point next)
+    {
+        for(auto& shard : shards)
+        {
+            if(shard.get() != busy && shard->sleeper.sleeping())
+            {
+                shard->sleeper.wakeup(next);
+                return;
+            }
+        }
+    }
+
+    void worker(Shard& shard,
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+            stop_token token,
+#else
+            const stop_token& token,
+#endif
+            ThreadAttributes attributes)
+    {
+        applyThreadAttributes(attributes);
+
+        while(!token.stop_requested())
+        {
+            shard.busy = true;
+            shard.scheduler.run(clock_type::now());
+            shard.busy = false;
+
+            time_point next;
+            bool any = shard.scheduler.next_wakeup(next);
+
+            for(auto& other : shards)
+            {
+                if(other.get() == &shard || !other->busy) continue;
+
+                while(other->scheduler.run_ready(clock_type::now()))
+                    ++shard.stolen;
+
+                // Look in again when its next item comes due, should it still be stuck
+                time_point theirs;
+
+                if(other->busy && other->scheduler.next_wakeup(theirs) &&
+                   (!any || next > theirs))
+                {
+                    next = theirs;
+                    any = true;
+                }
+            }
+
+            shard.sleeper.sleep(any, next);
+        }
+    }
+
+    /// Shard 'i' gets a CPU of its own from those configured, round robin, and a numbered name
+    static ThreadAttributes shardAttributes(ThreadAttributes attributes, std::size_t i)
+    {
+        if(!attributes.cpus.empty())
+            attributes.cpus = { attributes.cpus[i % attributes.cpus.size()] };
+
+        if(!attributes.name.empty())
+            attributes.name += '/' + std::to_string(i);
+
+        return attributes;
+    }
+
+public:
+    /// \param count number of shards, defaults to one per core
+    ShardedScheduler(EnttHelper eh,
+                     unsigned count = std::thread::hardware_concurrency(),
+                     duration_type resolution = internal::SchedulerTraits<duration_type>::resolution()) :
+        Agent(eh)
+    {
+        if(count == 0) count = 1;
+
+        shards.reserve(count);
+
+        for(unsigned i = 0; i < count; ++i)
+            shards.emplace_back(new Shard(this, resolution));
+    }
+
+    /// NOTE: Be sure to request stop beforehand
+    ~ShardedScheduler()
+    {
+        join();
+    }
+
+    std::size_t shardCount() const { return shards.size(); }
+
+    scheduler_type& scheduler(std::size_t shard) { return shards[shard]->scheduler; }
+
+    typedef typename scheduler_type::priorities priorities;
+
+    typedef typename scheduler_type::handle_type handle_type;
+
+    /// Places 'agent' on the least loaded shard
+    /// \return handle whose scheduler() is that of the shard chosen
+    handle_type add(agent_type* agent, time_point initial_wakeup,
+                    priorities priority = priorities::idle)
+    {
+        std::size_t chosen = 0;
+        std::size_t lowest = std::numeric_limits<std::size_t>::max();
+
+        for(std::size_t i = 0; i < shards.size(); ++i)
+        {
+            std::size_t load = shards[i]->scheduler.count();
+
+            if(load < lowest)
+            {
+                lowest = load;
+                chosen = i;
+            }
+        }
+
+        return shards[chosen]->scheduler.add(agent, initial_wakeup, clock_type::now(), priority);
+    }
+
+    /// Add 'agent' to run 'delay' from now
+    handle_type add(agent_type* agent, duration_type delay = duration_type::zero(),
+                    priorities priority = priorities::idle)
+    {
+        return add(agent, clock_type::now() + delay, priority);
+    }
+
+    ShardStatistics statistics(std::size_t shard) const
+    {
+        const Shard& s = *shards[shard];
+        typename scheduler_type::Statistics stats = s.scheduler.statistics();
+
+        return ShardStatistics {
+            s.scheduler.count(),
+            s.scheduler.backlog(),
+            stats.runs,
+            s.stolen,
+            stats.lateness_total,
+            stats.lateness_max
+        };
+    }
+
+    /// Starts one thread per shard
+    void run(const stop_token& token)
+    {
+        status(Status::Starting);
+
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        stopCallback.emplace(token, WakeAll{this});
+#else
+        // DEBT: Without stop_callback, a shard doesn't notice stop until its next wakeup
+#endif
+
+        const ThreadAttributes attributes = threadAttributes();
+
+        for(std::size_t i = 0; i < shards.size(); ++i)
+        {
+            shards[i]->thread = std::thread(&this_type::worker, this, std::ref(*shards[i]),
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+                                        token,
+#else
+                                        std::ref(token),
+#endif
+                                        shardAttributes(attributes, i));
+        }
+
+        status(Status::Running);
+    }
+
+    /// Blocks until all shard threads exit
+    void join()
+    {
+        bool any = false;
+
+        for(auto& shard : shards)
+        {
+            if(shard->thread.joinable())
+            {
+                shard->thread.join();
+                any = true;
+            }
+        }
+
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+        stopCallback.reset();
+#endif
+
+        if(any) status(Status::Stopped);
+    }
+};
+
+}}}
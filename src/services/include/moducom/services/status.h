@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 
 namespace moducom { namespace services {
@@ -34,6 +35,75 @@ inline bool is_running(Status status)
     return status == Status::Running || status == Status::Degraded || status == Status::Waiting;
 }
 
+/// Number of distinct Status values, handy for tallying
+constexpr unsigned status_count = static_cast<unsigned>(Status::Error) + 1;
+
+
+/// Tally of how many agents sit in each Status
+/// @details Meant to be maintained incrementally (one transition at a time) so that
+/// asking for overall health is O(1) no matter how many agents feed into it
+class StatusRollup
+{
+public:
+    typedef unsigned counter_type;
+
+private:
+    std::array<counter_type, status_count> counts_ {};
+    counter_type total_ = 0;
+
+public:
+    counter_type count(Status status) const
+    {
+        return counts_[static_cast<unsigned>(status)];
+    }
+
+    counter_type total() const { return total_; }
+
+    counter_type running() const
+    {
+        return count(Status::Running) + count(Status::Degraded) + count(Status::Waiting);
+    }
+
+    /// Adjusts tally for 'status' by 'delta', which may be negative
+    void adjust(Status status, int delta)
+    {
+        counts_[static_cast<unsigned>(status)] += delta;
+        total_ += delta;
+    }
+
+    /// Derives one representative status from the tally
+    /// @details Any error wins.  If everyone is running we report the 'worst' flavor of
+    /// running, and partially running is considered Degraded.  Otherwise we report the most
+    /// 'active' transitional state present
+    Status overall() const
+    {
+        if(total_ == 0) return Status::Unstarted;
+
+        if(count(Status::Error) > 0) return Status::Error;
+
+        counter_type running = this->running();
+
+        if(running == total_)
+        {
+            if(count(Status::Degraded) > 0) return Status::Degraded;
+            if(count(Status::Running) > 0) return Status::Running;
+            return Status::Waiting;
+        }
+
+        if(running > 0) return Status::Degraded;
+
+        for(Status s : { Status::Stopping, Status::Pausing,
+                         Status::Starting, Status::Started,
+                         Status::WaitingOnDependency, Status::Paused,
+                         Status::Stopped })
+        {
+            if(count(s) > 0) return s;
+        }
+
+        return Status::Unstarted;
+    }
+};
+
 
 struct Progress
 {
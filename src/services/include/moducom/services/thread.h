@@ -0,0 +1,192 @@
+/**
+ * @file
+ * @brief Placement, scheduling class and naming for agent threads
+ * @details Applied by each thread to itself as it starts, so there is no window where another
+ *          thread fiddles with a running one.  Linux only for now.  Elsewhere anything beyond
+ *          defaults is reported as unsupported
+ */
+#pragma once
+
+#include "../internal/numa.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if __linux__
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace moducom { namespace services {
+
+/// How an agent's thread is to be placed, prioritized and named
+struct ThreadAttributes
+{
+    enum class Policy
+    {
+        Inherit,    ///< leave as created
+        Other,      ///< SCHED_OTHER, with 'priority' as nice value -20 (highest) to 19
+        Fifo        ///< SCHED_FIFO, with 'priority' 1 (lowest) to 99.  Usually needs CAP_SYS_NICE
+    };
+
+    /// CPUs thread may run on.  Empty means leave as is
+    std::vector<unsigned> cpus;
+    /// NUMA node to run on and allocate from.  Narrows 'cpus' to that node's, or stands in
+    /// for them if empty.  -1 means leave as is
+    int node = -1;
+    Policy policy = Policy::Inherit;
+    int priority = 0;
+    /// Empty means derive from agent's Description.  Linux keeps only the first 15 characters
+    std::string name;
+
+    bool defaults() const
+    {
+        return cpus.empty() && node < 0 && policy == Policy::Inherit && name.empty();
+    }
+};
+
+/// Where an agent's thread and service ended up, and where its work comes from
+struct NumaPlacement
+{
+    /// Node agent's thread last started on, or -1 if unknown
+    int thread = -1;
+    /// Node backing agent's service, or -1 if unknown
+    int memory = -1;
+    /// Wakes and messages handed over from the same node as 'thread'
+    std::uint64_t local = 0;
+    /// ... and from any other node
+    std::uint64_t remote = 0;
+};
+
+namespace internal {
+
+/// CPU time consumed so far by the calling thread, or zero where unsupported
+/// NOTE: A syscall rather than vDSO, so best sampled rather than called per iteration
+inline std::chrono::nanoseconds thread_cpu_time()
+{
+#if __linux__
+    timespec ts;
+
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+#endif
+    return std::chrono::nanoseconds::zero();
+}
+
+/// Applies 'attributes' to the calling thread, carrying on past any one failure
+/// \return empty on success, otherwise a description of everything which failed
+inline std::string apply(const ThreadAttributes& attributes)
+{
+    typedef ThreadAttributes::Policy policy;
+
+    std::string errors;
+
+    auto fail = [&](const char* what, int error)
+    {
+        if(!errors.empty()) errors += "; ";
+        errors += what;
+#if __linux__
+        errors += ": ";
+        errors += std::strerror(error);
+#endif
+    };
+
+#if __linux__
+    const pthread_t self = pthread_self();
+    int result;
+
+    std::vector<unsigned> cpus = attributes.cpus;
+
+    if(attributes.node >= 0)
+    {
+        std::vector<unsigned> local = moducom::internal::numa::cpus(attributes.node);
+
+        if(cpus.empty())
+            cpus = local;
+        else
+            cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&](unsigned cpu)
+                { return std::find(local.begin(), local.end(), cpu) == local.end(); }),
+                cpus.end());
+
+        if(cpus.empty()) fail("node has none of the requested CPUs", EINVAL);
+    }
+
+    if(!cpus.empty())
+    {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        for(unsigned cpu : cpus)
+            if(cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+
+        result = pthread_setaffinity_np(self, sizeof(set), &set);
+        if(result != 0) fail("affinity", result);
+    }
+
+    // Affinity first, so that anything this thread touches from here on lands local
+    if(attributes.node >= 0)
+    {
+        result = moducom::internal::numa::prefer(attributes.node);
+        if(result != 0) fail("memory policy", result);
+    }
+
+    switch(attributes.policy)
+    {
+        case policy::Inherit:
+            break;
+
+        case policy::Other:
+        {
+            sched_param param {};
+
+            result = pthread_setschedparam(self, SCHED_OTHER, &param);
+            if(result != 0) fail("SCHED_OTHER", result);
+
+            // Linux keeps nice per thread, so this leaves the rest of the process alone
+            if(setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), attributes.priority) != 0)
+                fail("nice", errno);
+            break;
+        }
+
+        case policy::Fifo:
+        {
+            sched_param param {};
+            param.sched_priority = attributes.priority;
+
+            result = pthread_setschedparam(self, SCHED_FIFO, &param);
+            if(result != 0) fail("SCHED_FIFO", result);
+            break;
+        }
+    }
+
+    if(!attributes.name.empty())
+    {
+        // 16 including null terminator, or pthread_setname_np refuses outright
+        std::string name = attributes.name.substr(0, 15);
+
+        result = pthread_setname_np(self, name.c_str());
+        if(result != 0) fail("name", result);
+    }
+#else
+    if(!attributes.cpus.empty()) fail("affinity unsupported on this platform", 0);
+    if(attributes.node >= 0) fail("NUMA placement unsupported on this platform", 0);
+    if(attributes.policy != policy::Inherit) fail("policy unsupported on this platform", 0);
+    // DEBT: Naming is harmless to skip, so we quietly do
+#endif
+
+    return errors;
+}
+
+}
+
+}}
@@ -18,7 +18,12 @@ namespace internal {
 class ServiceSignalingStopToken : public ServiceToken
 {
 protected:
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+    // By value, since callers typically hand us a temporary from stop_source::token()
+    const stop_token stopToken;
+#else
     const stop_token& stopToken;
+#endif
 
     ServiceSignalingStopToken(const stop_token& stopToken) :
             stopToken(stopToken) {}
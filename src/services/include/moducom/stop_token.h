@@ -2,11 +2,14 @@
 
 #include <atomic>
 
+// NOTE: Name is historical, from when callbacks rode on an entt::sigh.  Enables the full
+// stop_source/stop_token/stop_callback flavor
 #define FEATURE_MC_SERVICES_ENTT_STOPTOKEN 1
 
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-#include <entt/signal/sigh.hpp>
-#include <entt/signal/emitter.hpp>
+#include <cstdint>
+#include <thread>
+#include <utility>
 #endif
 
 // doing this since C++20 is still so new.
@@ -16,13 +19,310 @@ namespace moducom { namespace services {
 
 class stop_source;
 
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+namespace internal {
+
+/// Shared by a stop_source, its copies and every stop_token handed out, as per std::jthread
+/// @details Allocated once when stop_source is created, and freed along with the last
+/// source or token referring to it.  Callbacks live in an intrusive list threaded through
+/// stop_callback objects themselves, so neither registering nor requesting stop allocates.
+/// The list is guarded by a spin bit alongside the stop bit, held only for a few pointer
+/// writes and never while a callback runs.  A state may be linked beneath a parent one,
+/// whose stop then reaches it (and in turn its own children) through an ordinary callback
+class stop_state
+{
+public:
+    struct callback_node
+    {
+        void (*invoke)(callback_node*);
+        callback_node* prev = nullptr;
+        callback_node* next = nullptr;
+        // in list, awaiting stop.  Guarded by spin bit
+        bool linked = false;
+        // set by request_stop once callback has returned
+        std::atomic<bool> done {false};
+        // lets a callback which destroys its own stop_callback tell request_stop so
+        bool* destroyed = nullptr;
+
+        explicit callback_node(void (*invoke)(callback_node*)) : invoke(invoke) {}
+    };
+
+private:
+    typedef std::uint32_t value_type;
+
+    static constexpr value_type stop_requested_bit = 1;
+    static constexpr value_type locked_bit = 2;
+    // stop_source count lives in the remaining bits
+    static constexpr value_type source_increment = 4;
+
+    std::atomic<value_type> value {source_increment};
+    // sources and tokens alike
+    std::atomic<value_type> owners {1};
+
+    callback_node* head = nullptr;
+    // Guarded by spin bit
+    std::thread::id requester;
+
+    // Registered with parent, embedded so that linking never allocates
+    struct link_node : callback_node
+    {
+        stop_state* child;
+
+        explicit link_node(stop_state* child) :
+            callback_node(&stop_state::propagate),
+            child(child)
+        {}
+    };
+
+    link_node link_ {this};
+    // Only link() and unlink() touch this, which callers serialize
+    stop_state* parent_ = nullptr;
+
+    static void pause() { std::this_thread::yield(); }
+
+    static void propagate(callback_node* node)
+    {
+        stop_state* child = static_cast<link_node*>(node)->child;
+
+        // A callback further down may drop the child's last source or token.  Or the last
+        // may already be gone, in which case child's destructor is waiting in unlink() for
+        // us to return, and there's nothing worth stopping
+        if(!child->try_add_owner()) return;
+
+        child->request_stop();
+        if(child->remove_owner()) delete child;
+    }
+
+    /// Takes spin bit, unless 'fail_if' bits are found set first
+    /// \return false if bailed out per 'fail_if'
+    bool lock(value_type fail_if, value_type also_set = 0)
+    {
+        value_type v = value.load(std::memory_order_relaxed);
+
+        for(;;)
+        {
+            if(v & fail_if) return false;
+
+            if(v & locked_bit)
+            {
+                pause();
+                v = value.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            if(value.compare_exchange_weak(v, v | locked_bit | also_set,
+                                           std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        }
+    }
+
+    void unlock()
+    {
+        value.fetch_and(~locked_bit, std::memory_order_release);
+    }
+
+public:
+    stop_state() = default;
+
+    stop_state(const stop_state&) = delete;
+
+    ~stop_state() { unlink(); }
+
+    void add_owner() noexcept
+    {
+        owners.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// As add_owner(), unless last owner is already gone
+    /// \return false if no owners remain, and so we're on our way to being deleted
+    bool try_add_owner() noexcept
+    {
+        value_type o = owners.load(std::memory_order_relaxed);
+
+        do
+        {
+            if(o == 0) return false;
+        }
+        while(!owners.compare_exchange_weak(o, o + 1, std::memory_order_relaxed));
+
+        return true;
+    }
+
+    /// \return true if caller was the last owner, and so must delete
+    bool remove_owner() noexcept
+    {
+        return owners.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    void add_source() noexcept
+    {
+        value.fetch_add(source_increment, std::memory_order_relaxed);
+        add_owner();
+    }
+
+    /// \return true if caller was the last owner, and so must delete
+    bool remove_source() noexcept
+    {
+        value.fetch_sub(source_increment, std::memory_order_release);
+        return remove_owner();
+    }
+
+    bool stop_requested() const noexcept
+    {
+        return value.load(std::memory_order_acquire) & stop_requested_bit;
+    }
+
+    /// Stop already requested, or some stop_source remains which could yet request it
+    bool stop_possible() const noexcept
+    {
+        value_type v = value.load(std::memory_order_acquire);
+        return (v & stop_requested_bit) || v >= source_increment;
+    }
+
+    /// Runs every registered callback on the calling thread
+    /// \return false if stop had already been requested
+    bool request_stop() noexcept
+    {
+        if(!lock(stop_requested_bit, stop_requested_bit)) return false;
+
+        requester = std::this_thread::get_id();
+
+        while(head != nullptr)
+        {
+            callback_node* cb = head;
+
+            head = cb->next;
+            if(head != nullptr) head->prev = nullptr;
+            cb->linked = false;
+
+            bool destroyed = false;
+            cb->destroyed = &destroyed;
+
+            unlock();
+
+            cb->invoke(cb);
+
+            if(!destroyed)
+            {
+                cb->destroyed = nullptr;
+                cb->done.store(true, std::memory_order_release);
+            }
+
+            lock(0);
+        }
+
+        unlock();
+        return true;
+    }
+
+    /// \return false if not registered, since stop was already requested or can never be
+    bool add(callback_node* cb) noexcept
+    {
+        if(!lock(stop_requested_bit)) return false;
+
+        if(value.load(std::memory_order_relaxed) < source_increment)
+        {
+            unlock();
+            return false;
+        }
+
+        cb->next = head;
+        if(head != nullptr) head->prev = cb;
+        head = cb;
+        cb->linked = true;
+
+        unlock();
+        return true;
+    }
+
+    /// Unregisters 'cb', waiting on its callback if another thread is running it right now
+    void remove(callback_node* cb) noexcept
+    {
+        lock(0);
+
+        if(cb->linked)
+        {
+            if(cb->prev != nullptr)
+                cb->prev->next = cb->next;
+            else
+                head = cb->next;
+
+            if(cb->next != nullptr) cb->next->prev = cb->prev;
+
+            cb->linked = false;
+            unlock();
+            return;
+        }
+
+        const bool ours = requester == std::this_thread::get_id();
+
+        unlock();
+
+        if(ours)
+        {
+            // Callback is destroying itself, or has already run on this thread
+            if(cb->destroyed != nullptr) *cb->destroyed = true;
+            return;
+        }
+
+        while(!cb->done.load(std::memory_order_acquire)) pause();
+    }
+
+    /// Stops us whenever 'parent' is, including right away if it already was
+    /// @details Counts as a source of ours for as long as it's linked
+    void link(stop_state* parent) noexcept
+    {
+        unlink();
+
+        if(parent == nullptr) return;
+
+        // May have propagated, or been unlinked mid propagation, last time around
+        link_.done.store(false, std::memory_order_relaxed);
+        link_.destroyed = nullptr;
+        value.fetch_add(source_increment, std::memory_order_relaxed);
+
+        if(parent->add(&link_))
+        {
+            parent->add_owner();
+            parent_ = parent;
+            return;
+        }
+
+        value.fetch_sub(source_increment, std::memory_order_release);
+
+        if(parent->stop_requested()) request_stop();
+    }
+
+    /// Detaches from parent, waiting on propagation if it's underway on another thread
+    void unlink() noexcept
+    {
+        if(parent_ == nullptr) return;
+
+        parent_->remove(&link_);
+        value.fetch_sub(source_increment, std::memory_order_release);
+
+        if(parent_->remove_owner()) delete parent_;
+        parent_ = nullptr;
+    }
+};
+
+}
+#endif
+
 class stop_token
 {
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-    stop_source* stop_source_;
+    internal::stop_state* state_;
+
+    explicit stop_token(internal::stop_state* state) : state_(state)
+    {
+        if(state_ != nullptr) state_->add_owner();
+    }
 
-    stop_token(stop_source& source) :
-        stop_source_(&source) {}
+    void release()
+    {
+        if(state_ != nullptr && state_->remove_owner()) delete state_;
+    }
 #else
     //bool stop_requested_ = false;
     std::atomic<bool> stop_requested_ = false;
@@ -35,30 +335,46 @@ class stop_token
 
 public:
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-    stop_token() : stop_source_{nullptr} {}
+    stop_token() noexcept : state_{nullptr} {}
 
-    stop_token(const stop_token& copy_from) :
-        stop_source_(copy_from.stop_source_)
+    stop_token(const stop_token& copy_from) noexcept :
+        stop_token(copy_from.state_)
     {
+    }
 
+    stop_token(stop_token&& move_from) noexcept :
+        state_(move_from.state_)
+    {
+        move_from.state_ = nullptr;
     }
 
-    stop_token(stop_token&& move_from) :
-        stop_source_(move_from.stop_source_)
+    ~stop_token() { release(); }
+
+    stop_token& operator=(const stop_token& copy_from) noexcept
     {
-        move_from.stop_source_ = nullptr;
+        stop_token(copy_from).swap(*this);
+        return *this;
     }
 
+    stop_token& operator=(stop_token&& move_from) noexcept
+    {
+        stop_token(std::move(move_from)).swap(*this);
+        return *this;
+    }
+
+    void swap(stop_token& other) noexcept { std::swap(state_, other.state_); }
+
     [[nodiscard]] bool stop_possible() const noexcept
     {
-        return stop_source_ != nullptr;
+        return state_ != nullptr && state_->stop_possible();
     }
-#endif
 
     [[nodiscard]] bool stop_requested() const noexcept
-#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-    ;
+    {
+        return state_ != nullptr && state_->stop_requested();
+    }
 #else
+    [[nodiscard]] bool stop_requested() const noexcept
     {
         bool value = stop_requested_;
         return value;
@@ -67,32 +383,96 @@ public:
 };
 
 
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+struct nostopstate_t { explicit nostopstate_t() = default; };
+
+constexpr nostopstate_t nostopstate {};
+#endif
+
+
 class stop_source
 {
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-    std::atomic<bool> stop_requested_ = false;
-    entt::sigh<void ()> sigh_stop_requested;
+    internal::stop_state* state_;
 
-    template <class T>
-    friend class stop_callback;
+    void release()
+    {
+        if(state_ != nullptr && state_->remove_source()) delete state_;
+    }
 
 public:
-    [[nodiscard]] const bool stop_requested() const noexcept
+    stop_source() : state_(new internal::stop_state) {}
+
+    explicit stop_source(nostopstate_t) noexcept : state_(nullptr) {}
+
+    /// Creates a child source, stopped along with 'parent' but also able to stop on its own
+    explicit stop_source(const stop_token& parent) : state_(new internal::stop_state)
+    {
+        state_->link(parent.state_);
+    }
+
+    stop_source(const stop_source& copy_from) noexcept :
+        state_(copy_from.state_)
     {
-        return stop_requested_;
+        if(state_ != nullptr) state_->add_source();
     }
 
+    stop_source(stop_source&& move_from) noexcept :
+        state_(move_from.state_)
+    {
+        move_from.state_ = nullptr;
+    }
+
+    ~stop_source() { release(); }
+
+    stop_source& operator=(const stop_source& copy_from) noexcept
+    {
+        stop_source(copy_from).swap(*this);
+        return *this;
+    }
+
+    stop_source& operator=(stop_source&& move_from) noexcept
+    {
+        stop_source(std::move(move_from)).swap(*this);
+        return *this;
+    }
+
+    void swap(stop_source& other) noexcept { std::swap(state_, other.state_); }
+
+    [[nodiscard]] bool stop_requested() const noexcept
+    {
+        return state_ != nullptr && state_->stop_requested();
+    }
+
+    [[nodiscard]] bool stop_possible() const noexcept
+    {
+        return state_ != nullptr;
+    }
+
+    /// Runs registered callbacks on calling thread before returning
+    /// \return true if this call is the one which requested stop
     bool request_stop() noexcept
     {
-        stop_requested_ = true;
-        sigh_stop_requested.publish();
-        return true;
+        return state_ != nullptr && state_->request_stop();
+    }
+
+    [[nodiscard]] stop_token token() const noexcept
+    {
+        return stop_token(state_);
+    }
+
+    /// Makes us (and any copies) a child of 'parent', replacing any earlier parent
+    /// @details Tokens already handed out follow along.  Not thread safe against other
+    /// link()/unlink() calls on this source or its copies
+    void link(const stop_token& parent) noexcept
+    {
+        if(state_ != nullptr) state_->link(parent.state_);
     }
 
-    // DEBT: Should be a const, but non-const needed for sigh to work
-    [[nodiscard]] stop_token token() noexcept
+    /// Stop requests from parent no longer reach us
+    void unlink() noexcept
     {
-        return stop_token(*this);
+        if(state_ != nullptr) state_->unlink();
     }
 #else
     stop_token token_;
@@ -113,24 +493,26 @@ public:
 #endif
 };
 
-#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-inline bool stop_token::stop_requested() const noexcept
-{
-    return stop_possible() && stop_source_->stop_requested();
-}
-#endif
-
+/// As std::stop_callback: runs 'callback' once stop is requested, or right away in the
+/// constructor if it already was
+/// @details Destruction waits out a callback already running on another thread.  A callback
+/// may destroy its own stop_callback
 template <class Callback>
 class stop_callback
+#if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
+    : internal::stop_state::callback_node
+#endif
 {
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
-    entt::sink<void ()> sink_stop_requested;
+    typedef internal::stop_state::callback_node node_type;
 
+    // Keeps state alive for as long as we're registered with it
+    stop_token token_;
     Callback callback;
 
-    void enttFriendlyCallback()
+    static void invoke(node_type* node)
     {
-        callback();
+        static_cast<stop_callback*>(node)->callback();
     }
 #endif
 
@@ -139,17 +521,24 @@ public:
 
 #if FEATURE_MC_SERVICES_ENTT_STOPTOKEN
     template <class C>
-    stop_callback(stop_token st, C&& cb) :
-        sink_stop_requested{st.stop_source_->sigh_stop_requested},
-        // DEBT: Unknown if this does a proper forward, but I believe it does
-        callback{cb}
+    stop_callback(const stop_token& st, C&& cb) :
+        node_type(&stop_callback::invoke),
+        callback(std::forward<C>(cb))
     {
-        sink_stop_requested.connect<&stop_callback::enttFriendlyCallback>(this);
+        if(st.state_ == nullptr) return;
+
+        if(st.state_->add(this))
+            token_ = st;
+        else if(st.state_->stop_requested())
+            callback();
     }
 
+    stop_callback(const stop_callback&) = delete;
+    stop_callback& operator=(const stop_callback&) = delete;
+
     ~stop_callback()
     {
-        sink_stop_requested.disconnect<&stop_callback::enttFriendlyCallback>(this);
+        if(token_.state_ != nullptr) token_.state_->remove(this);
     }
 #endif
 };
@@ -164,4 +553,4 @@ stop_callback(stop_token, Callback) -> stop_callback<Callback>;
 #endif
 
 
-}}
\ No newline at end of file
+}}
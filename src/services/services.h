@@ -7,6 +7,7 @@
 #include <new>
 #include <moducom/stop_token.h>
 #include "moducom/services/token.h"
+#include "moducom/services/thread.h"
 
 namespace moducom { namespace services {
 
@@ -25,6 +26,28 @@ public:
     {
         return ThreadPreference::Default;
     }
+
+    /// Placement, scheduling and name for whichever thread runs this service.  Agent
+    /// configuration overrides this
+    static ThreadAttributes threadAttributes()
+    {
+        return {};
+    }
+
+    /// Whether run() may be called from several threads at once on one instance.  If so,
+    /// WorkerPool shares one instance among its threads rather than constructing one each
+    static constexpr bool reentrant()
+    {
+        return false;
+    }
+
+    /// Whether separate instances may be constructed on several threads at once, i.e. the
+    /// constructor touches nothing shared.  If so, EventManager::start_exp() constructs
+    /// them in parallel
+    static constexpr bool parallelConstruction()
+    {
+        return false;
+    }
 };
 
 